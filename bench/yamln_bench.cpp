@@ -0,0 +1,341 @@
+// Throughput benchmarks for yamln. Built with -Dbenchmarks=true and run with
+// `meson test --benchmark -C build` or directly as ./yamln_bench [scale].
+// Inputs are generated in memory so runs are reproducible without data files.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "../include/yamln.h"
+#include "../src/parser/yamln_parser.h"
+#include "../src/scan/yamln_scan.h"
+
+// Counts heap allocations for the parse_into() benchmark
+static std::atomic<size_t> g_allocations{0};
+
+void* operator new(size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+
+namespace {
+
+template <typename F>
+void run(const char* name, size_t bytes, int iterations, F&& fn) {
+    fn(); // warm up
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) fn();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    double per_iter = elapsed.count() / iterations;
+    std::printf("%-36s %10.3f ms %10.1f MB/s\n", name, per_iter * 1e3,
+                bytes / per_iter / (1024.0 * 1024.0));
+}
+
+// Array of records mixing every JSON value type
+std::string make_json_corpus(size_t records) {
+    std::string out = "[";
+    for (size_t i = 0; i < records; ++i) {
+        if (i) out += ",\n";
+        out += "{\"id\": " + std::to_string(i) +
+               ", \"name\": \"user_" + std::to_string(i) + "\\tx\"" +
+               ", \"score\": " + std::to_string(i * 0.25) +
+               ", \"active\": " + (i % 2 ? "true" : "false") +
+               ", \"tags\": [\"alpha\", \"beta\", \"gamma\"]" +
+               ", \"meta\": {\"created\": \"2025-01-01T00:00:00Z\", \"parent\": null}}";
+    }
+    out += "]";
+    return out;
+}
+
+void bench_json(size_t scale) {
+    std::string json = make_json_corpus(20000 * scale);
+    yamln::Node tree = yamln::parse(json);
+
+    std::printf("JSON corpus: %zu bytes\n", json.size());
+    run("parse (JSON fast path)", json.size(), 5, [&] { yamln::parse(json); });
+    run("parse (generic flow path)", json.size(), 5, [&] {
+        yamln::Parser p(json);
+        p.parse_document();
+    });
+    run("serialize_json", json.size(), 5, [&] { yamln::serialize_json(tree); });
+    run("serialize (YAML)", json.size(), 5, [&] { yamln::serialize(tree); });
+}
+
+// Mapping whose values are large literal and folded blocks, like embedded
+// certificate bundles or scripts
+std::string make_block_corpus(size_t lines) {
+    std::string out;
+    for (const char* header : {"pem: |\n", "sql: >\n"}) {
+        out += header;
+        for (size_t i = 0; i < lines; ++i) {
+            out += "  MIIFazCCA1OgAwIBAgIRAIIQz7DSQONZRGPgu2OCiwAwDQYJKoZIhvcNAQELBQAw";
+            out += std::to_string(i);
+            out += '\n';
+            if (i % 64 == 63) out += '\n';
+        }
+    }
+    out += "tail: 1\n";
+    return out;
+}
+
+void bench_block_scalar(size_t scale) {
+    std::string yaml = make_block_corpus(50000 * scale);
+    std::printf("Block scalar corpus: %zu bytes\n", yaml.size());
+    run("parse (block scalars)", yaml.size(), 5, [&] { yamln::parse(yaml); });
+}
+
+// Block-style configuration with nested mappings, sequences and anchors
+std::string make_yaml_corpus(size_t services) {
+    std::string out = "defaults: &defaults\n  replicas: 3\n  timeout: 2.5\n";
+    out += "services:\n";
+    for (size_t i = 0; i < services; ++i) {
+        std::string n = std::to_string(i);
+        out += "  svc_" + n + ":\n";
+        out += "    base: *defaults\n";
+        out += "    image: \"registry.local/svc-" + n + ":1.0\"\n";
+        out += "    enabled: true # toggled by deploy\n";
+        out += "    ports: [80, 443, " + n + "]\n";
+        out += "    env:\n";
+        out += "      - name: LEVEL\n        value: 'debug'\n";
+        out += "      - name: ID\n        value: " + n + "\n";
+    }
+    return out;
+}
+
+void bench_validate(size_t scale) {
+    std::string yaml = make_yaml_corpus(20000 * scale);
+    std::printf("YAML corpus: %zu bytes\n", yaml.size());
+    run("parse (YAML)", yaml.size(), 5, [&] { yamln::parse(yaml); });
+    run("validate", yaml.size(), 5, [&] { yamln::validate(yaml); });
+
+    std::string small = make_yaml_corpus(20);
+    std::vector<std::string_view> batch(2000 * scale, small);
+    run("validate_batch (small docs)", small.size() * batch.size(), 5,
+        [&] { yamln::validate_batch(batch); });
+}
+
+void bench_schema(size_t scale) {
+    yamln::Schema schema(yamln::parse(R"(
+type: object
+required: [defaults, services]
+properties:
+  defaults: {type: object}
+  services:
+    type: object
+    additionalProperties:
+      type: object
+      required: [image, ports]
+      properties:
+        image: {type: string}
+        enabled: {type: boolean}
+        ports: {type: array, items: {type: integer, minimum: 0, maximum: 65535}}
+        env:
+          type: array
+          items:
+            type: object
+            required: [name, value]
+            properties:
+              name: {enum: [LEVEL, ID]}
+)"));
+    std::string yaml = make_yaml_corpus(20000 * scale);
+    std::printf("Schema corpus: %zu bytes\n", yaml.size());
+    run("parse then Schema::check", yaml.size(), 5, [&] { schema.check(yamln::parse(yaml)); });
+    run("parse with fused schema", yaml.size(), 5, [&] { yamln::parse(yaml, schema); });
+}
+
+// Mapping of double-quoted messages in several scripts, with escapes
+std::string make_quoted_corpus(size_t entries) {
+    static const char* const messages[] = {
+        "Connection to \\\"primary\\\" refused, retrying in 5s\\n",
+        "Verbindung zum Server fehlgeschlagen: Zeitüberschreitung nach 30 Sekunden",
+        "Не удалось подключиться к серверу базы данных, повтор через 5 секунд",
+        "サーバーへの接続に失敗しました。5秒後に再試行します\\u3002",
+        "path C:\\\\data\\\\logs\\t\\u00e9t\\u00e9 \\U0001F600 done",
+    };
+    std::string out;
+    for (size_t i = 0; i < entries; ++i) {
+        out += "msg_" + std::to_string(i) + ": \"";
+        out += messages[i % 5];
+        out += "\"\n";
+    }
+    return out;
+}
+
+// Calls fn for the kernels of every instruction set level this CPU supports
+template <typename F>
+void for_each_isa(F&& fn) {
+    for (yamln::Isa isa : {yamln::Isa::Scalar, yamln::Isa::SSE42, yamln::Isa::AVX2, yamln::Isa::AVX512})
+        if (const yamln::ScanKernels* k = yamln::scan_kernels(isa)) fn(*k);
+}
+
+void bench_utf8(size_t scale) {
+    std::string ascii = make_yaml_corpus(20000 * scale);
+    std::string mixed = make_quoted_corpus(100000 * scale);
+    std::printf("UTF-8 corpora: %zu bytes ASCII, %zu bytes mixed\n", ascii.size(), mixed.size());
+    for (const std::string* text : {&ascii, &mixed}) {
+        const char* kind = text == &ascii ? "ASCII" : "mixed";
+        for_each_isa([&](const yamln::ScanKernels& k) {
+            std::string name = std::string("utf8 ") + k.name + " (" + kind + ")";
+            run(name.c_str(), text->size(), 20, [&] {
+                if (!k.validate_utf8(text->data(), text->size())) std::abort();
+            });
+        });
+    }
+    run("parse (quoted strings)", mixed.size(), 5, [&] { yamln::parse(mixed); });
+    run("validate (quoted strings)", mixed.size(), 5, [&] { yamln::validate(mixed); });
+}
+
+// Small event payloads as they arrive from a message bus, in YAML and JSON
+std::vector<std::string> make_messages(size_t count) {
+    std::vector<std::string> out;
+    for (size_t i = 0; i < count; ++i) {
+        std::string n = std::to_string(i);
+        if (i % 2) {
+            out.push_back("{\"event\": \"order.created\", \"id\": " + n +
+                          ", \"customer\": \"customer-account-" + n + "\", \"total\": 129.95" +
+                          ", \"items\": [{\"sku\": \"SKU-000-" + n + "\", \"qty\": 2}]" +
+                          ", \"tags\": [\"priority-shipping\", \"gift\"]}");
+        } else {
+            out.push_back("event: order.updated\nid: " + n + "\ncustomer: customer-account-" + n +
+                          "\nstatus: awaiting-fulfilment\nitems:\n  - sku: SKU-000-" + n +
+                          "\n    qty: 1\nnote: \"delivery window extended by carrier\"\n");
+        }
+    }
+    return out;
+}
+
+void bench_context(size_t scale) {
+    std::vector<std::string> messages = make_messages(64);
+    size_t bytes = 0;
+    for (const std::string& m : messages) bytes += m.size();
+    size_t rounds = 2000 * scale;
+    std::printf("Message corpus: %zu documents, %zu bytes\n", messages.size(), bytes);
+
+    size_t before = g_allocations.load();
+    run("parse (small documents)", bytes, (int)rounds, [&] {
+        for (const std::string& m : messages) yamln::parse(m);
+    });
+    double per_doc = double(g_allocations.load() - before) / ((rounds + 1) * messages.size());
+    std::printf("  %.2f allocations per document\n", per_doc);
+
+    yamln::ParserContext ctx;
+    yamln::Node out;
+    for (const std::string& m : messages) yamln::parse_into(ctx, m, out);
+    before = g_allocations.load();
+    run("parse_into (small documents)", bytes, (int)rounds, [&] {
+        for (const std::string& m : messages) yamln::parse_into(ctx, m, out);
+    });
+    per_doc = double(g_allocations.load() - before) / ((rounds + 1) * messages.size());
+    std::printf("  %.2f allocations per document\n", per_doc);
+}
+
+void bench_serialize(size_t scale) {
+    // Wide top-level sequence of records, the shape of a large export
+    yamln::Node tree = yamln::parse(make_json_corpus(200000 * scale));
+    std::string expected = yamln::serialize(tree);
+    if (yamln::serialize_parallel(tree) != expected) std::abort();
+    std::printf("Serialize corpus: %zu bytes of YAML output\n", expected.size());
+    run("serialize", expected.size(), 3, [&] { yamln::serialize(tree); });
+    // Fixed counts as well as the core count, so the scaling is measured even
+    // on small machines, where the extra threads only show the overhead
+    unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<unsigned> counts = {1, 2, 4, cores};
+    std::sort(counts.begin(), counts.end());
+    counts.erase(std::unique(counts.begin(), counts.end()), counts.end());
+    for (unsigned threads : counts) {
+        std::string name = "serialize_parallel (" + std::to_string(threads) + " threads)";
+        run(name.c_str(), expected.size(), 3, [&] { yamln::serialize_parallel(tree, threads); });
+    }
+}
+
+// Each level aliases the previous one ten times
+std::string make_nested_aliases(int levels) {
+    std::string doc = "l0: &a0 {v: 1}\n";
+    for (int i = 1; i < levels; ++i) {
+        doc += "l" + std::to_string(i) + ": &a" + std::to_string(i) + "\n";
+        for (int k = 0; k < 10; ++k)
+            doc += "  k" + std::to_string(k) + ": *a" + std::to_string(i - 1) + "\n";
+    }
+    return doc;
+}
+
+// A reloaded configuration with one changed key, compared against the old one
+void bench_diff(size_t scale) {
+    std::string yaml = make_yaml_corpus(26000 * scale);
+    yamln::Node from = yamln::parse(yaml);
+    yamln::Node to = from;
+    to["services"]["svc_777"]["image"] = "registry.local/svc-777:2.0";
+    std::printf("Diff corpus: %zu bytes, one changed key\n", yaml.size());
+    run("Node::hash", yaml.size(), 5, [&] { from.hash(); });
+    run("operator==", yaml.size(), 5, [&] { if (from == to) std::abort(); });
+    run("diff (Node)", yaml.size(), 5, [&] { if (yamln::diff(from, to).size() != 1) std::abort(); });
+
+    yamln::FrozenNode frozen_from(from);
+    run("FrozenNode (freeze)", yaml.size(), 5, [&] { yamln::FrozenNode f(from); });
+    yamln::FrozenNode frozen_to = frozen_from.with("services.svc_777.image", yamln::Node("registry.local/svc-777:2.0"));
+    run("diff (FrozenNode, after with)", yaml.size(), 1000, [&] {
+        if (yamln::diff(frozen_from, frozen_to).size() != 1) std::abort();
+    });
+    yamln::FrozenNode refrozen(to);
+    run("diff (FrozenNode, refrozen)", yaml.size(), 1000, [&] {
+        if (yamln::diff(frozen_from, refrozen).size() != 1) std::abort();
+    });
+
+    std::string nested = make_nested_aliases(12);
+    yamln::Node na = yamln::parse(nested), nb = yamln::parse(nested);
+    std::printf("Nested alias corpus: %zu bytes, 12 levels\n", nested.size());
+    run("Node::hash (nested aliases)", nested.size(), 1000, [&] { na.hash(); });
+    run("diff (nested aliases)", nested.size(), 1000, [&] { if (!yamln::diff(na, nb).empty()) std::abort(); });
+}
+
+// Scans over the corpora the kernels see in practice: quoted text, plain
+// scalars in block YAML and JSON strings
+void bench_scan(size_t scale) {
+    std::string quoted = make_quoted_corpus(100000 * scale);
+    std::string yaml = make_yaml_corpus(20000 * scale);
+    std::string json = make_json_corpus(20000 * scale);
+    std::printf("Scan corpora: %zu / %zu / %zu bytes\n", quoted.size(), yaml.size(), json.size());
+    for_each_isa([&](const yamln::ScanKernels& k) {
+        auto count = [](const std::string& text, auto find) {
+            size_t hits = 0;
+            for (const char *p = text.data(), *end = p + text.size(); (p = find(p, end)) != end; ++p) ++hits;
+            return hits;
+        };
+        std::string name = std::string("find_quote_or_backslash ") + k.name;
+        run(name.c_str(), quoted.size(), 20, [&] { count(quoted, k.find_quote_or_backslash); });
+        name = std::string("find_plain_stop ") + k.name;
+        run(name.c_str(), yaml.size(), 20, [&] { count(yaml, k.find_plain_stop); });
+        name = std::string("find_json_escape ") + k.name;
+        run(name.c_str(), json.size(), 20, [&] { count(json, k.find_json_escape); });
+    });
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    size_t scale = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1;
+    if (scale == 0) scale = 1;
+    std::printf("Scan kernels: %s (select with YAMLN_ISA=scalar|sse4.2|avx2|avx512)\n",
+                yamln::active_scan_kernels().name);
+    bench_json(scale);
+    bench_block_scalar(scale);
+    bench_validate(scale);
+    bench_schema(scale);
+    bench_utf8(scale);
+    bench_scan(scale);
+    bench_context(scale);
+    bench_serialize(scale);
+    bench_diff(scale);
+    return 0;
+}
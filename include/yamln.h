@@ -37,6 +37,12 @@
 #include <stdexcept>
 #include <optional>
 #include <memory>
+#include <cstdint>
+#include <atomic>
+#include <mutex>
+#include <string_view>
+#include <iterator>
+#include <cstddef>
 
 namespace yamln {
 
@@ -74,9 +80,12 @@ struct Node {
     Node(int i) : data(i) {}
     Node(double d) : data(d) {}
     Node(const std::string& s) : data(s) {}
+    Node(std::string&& s) : data(std::move(s)) {}
     Node(const char* s) : data(std::string(s)) {}
     Node(const Sequence& s) : data(s) {}
+    Node(Sequence&& s) : data(std::move(s)) {}
     Node(const Mapping& m) : data(m) {}
+    Node(Mapping&& m) : data(std::move(m)) {}
     Node(const NodeRef& ref) : data(ref) {}
 
     // Type checks
@@ -100,6 +109,10 @@ struct Node {
     Node& as_alias() { return *std::get<NodeRef>(data); }
     const Node& as_alias() const { return *std::get<NodeRef>(data); }
 
+    // Structural hash of the subtree: equal trees hash equal. Computed from
+    // the current contents on every call, so it walks the whole subtree.
+    __attribute__((visibility("default"))) std::uint64_t hash() const;
+
     // Object access
     Node& operator[](const std::string& key) {
         if (!is_mapping()) data = Mapping{};
@@ -129,8 +142,356 @@ struct Node {
     bool operator!=(const Node& other) const { return !(*this == other); }
 };
 
+// Location of a node inside a tree: mapping keys and sequence indices
+using PathSegment = std::variant<std::string, size_t>;
+using Path = std::vector<PathSegment>;
+
+// Single edit produced by diff()
+struct PatchOp {
+    enum class Kind { Add, Remove, Change };
+    Kind kind;
+    Path path;
+    Node value; // new value for Add/Change, null for Remove
+};
+
+using Patch = std::vector<PatchOp>;
+
+// Immutable YAML node. Children are held through shared pointers, so copies
+// are cheap and with() rebuilds only the nodes on the updated path while every
+// other subtree is shared with the original. Aliases are resolved into shared
+// subtrees when a Node is frozen.
+struct FrozenValue;
+class FrozenMapping;
+class FrozenSequence;
+
+class __attribute__((visibility("default"))) FrozenNode {
+public:
+    FrozenNode();
+    explicit FrozenNode(const Node& n);
+
+    // Type checks
+    inline bool is_mapping() const;
+    inline bool is_sequence() const;
+    inline bool is_string() const;
+    inline bool is_number() const;
+    inline bool is_bool() const;
+    inline bool is_null() const;
+
+    // Getters
+    inline const FrozenMapping& as_mapping() const;
+    inline const FrozenSequence& as_sequence() const;
+    inline const std::string& as_string() const;
+    inline double as_number() const;
+    inline bool as_bool() const;
+
+    // Read-only access, throws when the key or index is missing
+    const FrozenNode& operator[](const std::string& key) const;
+    const FrozenNode& operator[](size_t index) const;
+
+    // Returns a new tree with `value` stored at `path`. A dotted path ("a.b.0")
+    // indexes sequences by number; missing mapping keys are created.
+    FrozenNode with(const std::string& path, const Node& value) const;
+    FrozenNode with(const Path& path, const Node& value) const;
+
+    // Deep copy back into a mutable tree
+    Node thaw() const;
+
+    // Structural hash of the subtree, computed once when it was built: equal
+    // trees hash equal
+    inline std::uint64_t hash() const;
+
+    // True when both handles share the same subtree, so it cannot differ
+    bool same_as(const FrozenNode& other) const { return value_ == other.value_; }
+
+    bool operator==(const FrozenNode& other) const;
+    bool operator!=(const FrozenNode& other) const { return !(*this == other); }
+
+private:
+    // Only make_frozen() wraps raw values, so value_ is never null and its
+    // hash is always set
+    explicit FrozenNode(std::shared_ptr<const FrozenValue> v) : value_(std::move(v)) {}
+    friend FrozenNode make_frozen(std::shared_ptr<FrozenValue> value);
+
+    FrozenNode with_at(const Path& path, size_t depth, const FrozenNode& value) const;
+
+    std::shared_ptr<const FrozenValue> value_;
+};
+
+// Entries of frozen containers are stored in chunks of about sqrt(size)
+// behind shared pointers, next to an index of the chunks. with() copies the
+// index and the one chunk it changes and shares every other chunk, so an
+// update costs about 2 * sqrt(size) handle copies instead of the whole
+// container. The structural hash is a sum over the entries, so with() adjusts
+// it for the one entry it replaces.
+template <typename T>
+class FrozenChunks {
+public:
+    using Chunk = std::vector<T>;
+
+    class const_iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const T*;
+        using reference = const T&;
+
+        const_iterator() = default;
+        const_iterator(const std::shared_ptr<const Chunk>* chunk, size_t i) : chunk_(chunk), i_(i) {}
+
+        reference operator*() const { return (**chunk_)[i_]; }
+        pointer operator->() const { return &(**chunk_)[i_]; }
+        const_iterator& operator++() {
+            if (++i_ == (*chunk_)->size()) { ++chunk_; i_ = 0; }
+            return *this;
+        }
+        const_iterator operator++(int) { const_iterator old = *this; ++*this; return old; }
+        bool operator==(const const_iterator& o) const { return chunk_ == o.chunk_ && i_ == o.i_; }
+        bool operator!=(const const_iterator& o) const { return !(*this == o); }
+
+        // The chunk starting here, or nullptr inside a chunk. Walks over two
+        // versions of a container use it to skip the chunks they share.
+        const Chunk* chunk_start() const { return i_ == 0 ? chunk_->get() : nullptr; }
+        void skip_chunk() { ++chunk_; i_ = 0; }
+
+    private:
+        const std::shared_ptr<const Chunk>* chunk_ = nullptr;
+        size_t i_ = 0;
+    };
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    // Structural hash of the entries: equal containers hash equal
+    std::uint64_t hash() const { return hash_; }
+    const_iterator begin() const { return const_iterator(chunks_.data(), 0); }
+    const_iterator end() const { return const_iterator(chunks_.data() + chunks_.size(), 0); }
+
+    bool operator==(const FrozenChunks& other) const;
+    bool operator!=(const FrozenChunks& other) const { return !(*this == other); }
+
+protected:
+    static constexpr size_t kMinChunk = 16;
+
+    std::vector<std::shared_ptr<const Chunk>> chunks_; // never holds an empty chunk
+    size_t size_ = 0;
+    std::uint64_t hash_ = 0;
+};
+
+// Persistent mapping, iterated in key order like Mapping
+class __attribute__((visibility("default"))) FrozenMapping
+    : public FrozenChunks<std::pair<std::string, FrozenNode>> {
+public:
+    FrozenMapping() = default;
+    // `entries` must be sorted by key without duplicates
+    explicit FrozenMapping(std::vector<std::pair<std::string, FrozenNode>> entries);
+
+    // nullptr when the key is missing
+    const FrozenNode* find(const std::string& key) const;
+    size_t count(const std::string& key) const { return find(key) ? 1 : 0; }
+    // Throws std::out_of_range when the key is missing
+    const FrozenNode& at(const std::string& key) const;
+
+    // Copy with `key` set to `value`, inserted when missing
+    FrozenMapping with(const std::string& key, FrozenNode value) const;
+};
+
+// Persistent sequence; all chunks but the last hold exactly chunk_ items
+class __attribute__((visibility("default"))) FrozenSequence : public FrozenChunks<FrozenNode> {
+public:
+    FrozenSequence() = default;
+    explicit FrozenSequence(std::vector<FrozenNode> items);
+
+    const FrozenNode& operator[](size_t index) const { return (*chunks_[index / chunk_])[index % chunk_]; }
+    // Throws std::out_of_range past the end
+    const FrozenNode& at(size_t index) const;
+
+    // Copy with item `index` set to `value`, padded with nulls when it is
+    // past the end
+    FrozenSequence with(size_t index, FrozenNode value) const;
+
+private:
+    size_t chunk_ = kMinChunk;
+};
+
+struct FrozenValue {
+    std::variant<
+        std::nullptr_t,
+        bool,
+        int,
+        double,
+        std::string,
+        FrozenSequence,
+        FrozenMapping
+    > data;
+    std::uint64_t hash = 0; // structural hash of data, set when the value is built
+};
+
+template <typename T>
+bool FrozenChunks<T>::operator==(const FrozenChunks& other) const {
+    if (size_ != other.size_ || hash_ != other.hash_) return false;
+    if (chunks_ == other.chunks_) return true; // same shared chunks
+    for (const_iterator a = begin(), b = other.begin(); a != end(); ++a, ++b)
+        if (!(*a == *b)) return false;
+    return true;
+}
+
+bool FrozenNode::is_mapping() const { return std::holds_alternative<FrozenMapping>(value_->data); }
+bool FrozenNode::is_sequence() const { return std::holds_alternative<FrozenSequence>(value_->data); }
+bool FrozenNode::is_string()  const { return std::holds_alternative<std::string>(value_->data); }
+bool FrozenNode::is_number()  const { return std::holds_alternative<double>(value_->data) || std::holds_alternative<int>(value_->data); }
+bool FrozenNode::is_bool()    const { return std::holds_alternative<bool>(value_->data); }
+bool FrozenNode::is_null()    const { return std::holds_alternative<std::nullptr_t>(value_->data); }
+
+const FrozenMapping& FrozenNode::as_mapping() const { return std::get<FrozenMapping>(value_->data); }
+const FrozenSequence& FrozenNode::as_sequence() const { return std::get<FrozenSequence>(value_->data); }
+const std::string& FrozenNode::as_string() const { return std::get<std::string>(value_->data); }
+double FrozenNode::as_number() const {
+    if (std::holds_alternative<int>(value_->data)) return static_cast<double>(std::get<int>(value_->data));
+    return std::get<double>(value_->data);
+}
+bool FrozenNode::as_bool() const { return std::get<bool>(value_->data); }
+std::uint64_t FrozenNode::hash() const { return value_->hash; }
+
+// Holds the current version of a frozen tree for concurrent readers.
+// load() is wait-free: it registers in one of two reader counters, copies the
+// root handle and leaves. store() swaps the root in and waits for readers that
+// may still see the old version (an RCU grace period) before releasing it.
+// Readers keep their own handle, so old subtrees live as long as someone uses them.
+class __attribute__((visibility("default"))) SnapshotHolder {
+public:
+    SnapshotHolder();
+    explicit SnapshotHolder(FrozenNode root);
+    ~SnapshotHolder();
+
+    SnapshotHolder(const SnapshotHolder&) = delete;
+    SnapshotHolder& operator=(const SnapshotHolder&) = delete;
+
+    FrozenNode load() const;
+    void store(FrozenNode root);
+
+    // Publishes load().with(path, value) without losing concurrent updates
+    void update(const std::string& path, const Node& value);
+
+private:
+    struct Version { FrozenNode root; };
+
+    void publish(FrozenNode root);
+    void synchronize();
+
+    std::atomic<Version*> current_;
+    std::atomic<unsigned> epoch_{0};
+    struct alignas(64) ReaderCount { std::atomic<size_t> n{0}; };
+
+    mutable ReaderCount readers_[2];
+    std::mutex writer_;
+};
+
+// Thrown by parse() and returned by validate()
+struct __attribute__((visibility("default"))) ParseError : std::runtime_error {
+    int line, col;
+
+    ParseError(const std::string& msg, int line, int col)
+        : std::runtime_error("YAML parse error at line " + std::to_string(line) +
+                             ", col " + std::to_string(col) + ": " + msg),
+          line(line), col(col) {}
+};
+
+// Schema compiled from a JSON-Schema-like description, for example
+//   type: object
+//   required: [name]
+//   additionalProperties: false
+//   properties:
+//     name: {type: string}
+//     replicas: {type: integer, minimum: 1}
+//     mode: {enum: [fast, safe]}
+//     tags: {type: array, items: {type: string}}
+// Supported keywords are type, properties, required, additionalProperties
+// (a boolean or a rule for the remaining keys), items, enum, minimum and
+// maximum; others are ignored.
+struct CompiledSchema;
+
+class __attribute__((visibility("default"))) Schema {
+public:
+    // Throws std::runtime_error when the description is not a valid schema
+    explicit Schema(const Node& description);
+
+    // Checks an already built tree, throwing std::runtime_error with the path
+    // of the first violation
+    void check(const Node& root) const;
+
+    const CompiledSchema* compiled() const { return compiled_.get(); }
+
+private:
+    std::shared_ptr<const CompiledSchema> compiled_;
+};
+
+// Storage recycled between parse_into() calls, together with the anchor table.
+// A context belongs to one thread at a time.
+struct NodePool;
+
+class __attribute__((visibility("default"))) ParserContext {
+public:
+    ParserContext();
+    ~ParserContext();
+
+    ParserContext(const ParserContext&) = delete;
+    ParserContext& operator=(const ParserContext&) = delete;
+
+    // Releases everything kept for reuse
+    void clear();
+
+private:
+    // NodePool is internal; only parse_into() reaches it
+    friend void parse_into(ParserContext& ctx, const std::string& yaml, Node& out);
+
+    std::unique_ptr<NodePool> pool_;
+};
+
 // Public API
 __attribute__((visibility("default"))) std::string serialize(const Node& n);
+
+// Produces exactly the text of serialize(). The size of every top-level entry
+// is computed first, on up to `threads` threads (0 picks the hardware
+// concurrency); the output is then allocated once and the entries are written
+// concurrently at their offsets. Worth it for large trees with many top-level
+// entries.
+__attribute__((visibility("default"))) std::string serialize_parallel(const Node& n, unsigned threads = 0);
 __attribute__((visibility("default"))) Node parse(const std::string& yaml);
 
+// Parses and checks against `schema` in the same pass. Violations are thrown
+// as ParseError naming the path and position of the offending value. Accepts
+// exactly the documents for which parse() succeeds and Schema::check() passes;
+// like there, only the last value of a duplicated key is checked.
+// The JSON fast path is not used here.
+__attribute__((visibility("default"))) Node parse(const std::string& yaml, const Schema& schema);
+
+// Parses into `out`, first taking apart the tree it already holds and keeping
+// its strings, sequence buffers and map nodes in `ctx`. The new document is
+// built from that storage, so a stream of similarly shaped documents parsed
+// into the same Node reaches a steady state without heap allocations.
+// On ParseError `out` is left null.
+__attribute__((visibility("default"))) void parse_into(ParserContext& ctx, const std::string& yaml, Node& out);
+
+// Checks that parse() would accept the document without building the tree.
+// Returns the error parse() would throw, or nothing when the input is valid.
+__attribute__((visibility("default"))) std::optional<ParseError> validate(std::string_view yaml);
+
+// Validates every document on up to `threads` threads (0 picks the hardware
+// concurrency). Results are in input order.
+__attribute__((visibility("default"))) std::vector<std::optional<ParseError>>
+validate_batch(const std::vector<std::string_view>& documents, unsigned threads = 0);
+
+// Emits compact JSON. Aliases are written out in full; NaN and infinities become null.
+__attribute__((visibility("default"))) std::string serialize_json(const Node& n);
+
+// Computes the edits turning `from` into `to` in one walk over both trees.
+// Aliases are compared by the content of their targets.
+__attribute__((visibility("default"))) Patch diff(const Node& from, const Node& to);
+
+// Same edits for frozen trees. Shared subtrees and subtrees with equal hashes
+// are skipped unvisited, so comparing two versions of a tree related by
+// with() only visits the entries of containers on the changed paths.
+__attribute__((visibility("default"))) Patch diff(const FrozenNode& from, const FrozenNode& to);
+__attribute__((visibility("default"))) void apply_patch(Node& root, const Patch& patch);
+
 } // namespace yamln
@@ -0,0 +1,183 @@
+#include "yamln_diff.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace yamln {
+
+namespace {
+
+// Shared by both walks: Mapping and FrozenMapping iterate in key order, and
+// Sequence and FrozenSequence index from 0. Derived::thaw() turns a subtree
+// into the Node stored in a patch.
+template <typename Derived>
+struct DiffWalk {
+    Path path;
+    Patch out;
+
+    void emit(PatchOp::Kind kind, Node value) {
+        out.push_back({kind, path, std::move(value)});
+    }
+
+    template <typename Map>
+    void mapping(const Map& ma, const Map& mb) {
+        auto ia = ma.begin();
+        auto ib = mb.begin();
+        while (ia != ma.end() || ib != mb.end()) {
+            if (ia != ma.end() && ib != mb.end() && Derived::skip_shared(ia, ib)) continue;
+            if (ib == mb.end() || (ia != ma.end() && ia->first < ib->first)) {
+                path.emplace_back(ia->first);
+                emit(PatchOp::Kind::Remove, Node());
+                path.pop_back();
+                ++ia;
+            } else if (ia == ma.end() || ib->first < ia->first) {
+                path.emplace_back(ib->first);
+                emit(PatchOp::Kind::Add, Derived::thaw(ib->second));
+                path.pop_back();
+                ++ib;
+            } else {
+                path.emplace_back(ia->first);
+                static_cast<Derived*>(this)->node(ia->second, ib->second);
+                path.pop_back();
+                ++ia; ++ib;
+            }
+        }
+    }
+
+    template <typename Seq>
+    void sequence(const Seq& sa, const Seq& sb) {
+        size_t common = std::min(sa.size(), sb.size());
+        auto ia = sa.begin();
+        auto ib = sb.begin();
+        for (size_t i = 0; i < common;) {
+            if (size_t skipped = Derived::skip_shared(ia, ib)) {
+                i += skipped;
+                continue;
+            }
+            path.emplace_back(i);
+            static_cast<Derived*>(this)->node(*ia, *ib);
+            path.pop_back();
+            ++ia; ++ib; ++i;
+        }
+        for (size_t i = common; i < sb.size(); ++i) {
+            path.emplace_back(i);
+            emit(PatchOp::Kind::Add, Derived::thaw(sb[i]));
+            path.pop_back();
+        }
+        // Highest index first so the patch can be applied front to back
+        for (size_t i = sa.size(); i > common; --i) {
+            path.emplace_back(i - 1);
+            emit(PatchOp::Kind::Remove, Node());
+            path.pop_back();
+        }
+    }
+};
+
+// Nothing is cached in a Node, so the trees are compared directly in one
+// walk. Aliases compare by the hash of their targets, which is memoized for
+// the whole diff: targets nest, and comparing them by content would revisit
+// them once per alias.
+struct NodeWalk : DiffWalk<NodeWalk> {
+    AliasHashes aliases;
+
+    static const Node& thaw(const Node& n) { return n; }
+    template <typename It>
+    static size_t skip_shared(It&, It&) { return 0; }
+
+    void node(const Node& from, const Node& to) {
+        if (from.is_mapping() && to.is_mapping()) return mapping(from.as_mapping(), to.as_mapping());
+        if (from.is_sequence() && to.is_sequence()) return sequence(from.as_sequence(), to.as_sequence());
+        if (from.is_alias() && to.is_alias()) {
+            if (&from.as_alias() == &to.as_alias() ||
+                hash_tree(from, aliases) == hash_tree(to, aliases)) return;
+        } else if (from == to) {
+            return;
+        }
+        emit(PatchOp::Kind::Change, to);
+    }
+};
+
+// Frozen values carry the hash they were built with, so a shared or equal
+// subtree is skipped without being visited. Versions made by with() also
+// share all but one chunk of each container on the path, and those chunks
+// are skipped whole.
+struct FrozenWalk : DiffWalk<FrozenWalk> {
+    static Node thaw(const FrozenNode& n) { return n.thaw(); }
+
+    // Entries skipped when both iterators start the same chunk
+    template <typename It>
+    static size_t skip_shared(It& a, It& b) {
+        const auto* chunk = a.chunk_start();
+        if (!chunk || chunk != b.chunk_start()) return 0;
+        a.skip_chunk();
+        b.skip_chunk();
+        return chunk->size();
+    }
+
+    void node(const FrozenNode& from, const FrozenNode& to) {
+        if (from.same_as(to) || from.hash() == to.hash()) return;
+        if (from.is_mapping() && to.is_mapping()) return mapping(from.as_mapping(), to.as_mapping());
+        if (from.is_sequence() && to.is_sequence()) return sequence(from.as_sequence(), to.as_sequence());
+        emit(PatchOp::Kind::Change, to.thaw());
+    }
+};
+
+} // namespace
+
+Patch diff(const Node& from, const Node& to) {
+    NodeWalk walk;
+    walk.node(from, to);
+    return std::move(walk.out);
+}
+
+Patch diff(const FrozenNode& from, const FrozenNode& to) {
+    FrozenWalk walk;
+    walk.node(from, to);
+    return std::move(walk.out);
+}
+
+void apply_patch(Node& root, const Patch& patch) {
+    for (const PatchOp& op : patch) {
+        if (op.path.empty()) {
+            if (op.kind == PatchOp::Kind::Remove) root = Node();
+            else root = op.value;
+            continue;
+        }
+
+        Node* parent = &root;
+        for (size_t i = 0; i + 1 < op.path.size(); ++i) {
+            const PathSegment& seg = op.path[i];
+            if (std::holds_alternative<std::string>(seg)) {
+                if (!parent->is_mapping()) throw std::runtime_error("Patch path does not match a mapping");
+                parent = &(*parent)[std::get<std::string>(seg)];
+            } else {
+                if (!parent->is_sequence()) throw std::runtime_error("Patch path does not match a sequence");
+                parent = &(*parent)[std::get<size_t>(seg)];
+            }
+        }
+
+        const PathSegment& last = op.path.back();
+        if (std::holds_alternative<std::string>(last)) {
+            if (!parent->is_mapping()) throw std::runtime_error("Patch path does not match a mapping");
+            const std::string& key = std::get<std::string>(last);
+            if (op.kind == PatchOp::Kind::Remove) {
+                std::get<Mapping>(parent->data).erase(key);
+            } else {
+                (*parent)[key] = op.value;
+            }
+        } else {
+            if (!parent->is_sequence()) throw std::runtime_error("Patch path does not match a sequence");
+            size_t index = std::get<size_t>(last);
+            Sequence& seq = std::get<Sequence>(parent->data);
+            if (op.kind == PatchOp::Kind::Remove) {
+                if (index >= seq.size()) throw std::runtime_error("Patch removes a missing sequence item");
+                seq.erase(seq.begin() + index);
+            } else if (op.kind == PatchOp::Kind::Add && index <= seq.size()) {
+                seq.insert(seq.begin() + index, op.value);
+            } else {
+                (*parent)[index] = op.value;
+            }
+        }
+    }
+}
+
+} // namespace yamln
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../../include/yamln.h"
+
+namespace yamln {
+
+std::uint64_t hash_bytes(const char* data, size_t len, std::uint64_t seed);
+std::uint64_t hash_combine(std::uint64_t seed, std::uint64_t value);
+
+// Bits of a double hashed so that values comparing equal hash equal
+std::uint64_t hash_double(double d);
+
+// Hashes of alias targets already seen in one pass, by target
+using AliasHashes = std::unordered_map<const Node*, std::uint64_t>;
+
+std::uint64_t hash_tree(const Node& n, AliasHashes& aliases);
+
+Patch diff(const Node& from, const Node& to);
+Patch diff(const FrozenNode& from, const FrozenNode& to);
+void apply_patch(Node& root, const Patch& patch);
+
+} // namespace yamln
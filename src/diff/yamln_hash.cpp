@@ -0,0 +1,81 @@
+#include "yamln_diff.h"
+#include <cstring>
+
+namespace yamln {
+
+namespace {
+
+constexpr std::uint64_t kFnvOffset = 0xcbf29ce484222325ULL;
+constexpr std::uint64_t kFnvPrime  = 0x100000001b3ULL;
+
+std::uint64_t mix(std::uint64_t x) {
+    x ^= x >> 30; x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27; x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+} // namespace
+
+std::uint64_t hash_bytes(const char* data, size_t len, std::uint64_t seed) {
+    std::uint64_t h = kFnvOffset ^ seed;
+    size_t i = 0;
+    for (; i + 8 <= len; i += 8) {
+        std::uint64_t w;
+        std::memcpy(&w, data + i, 8);
+        h = (h ^ w) * kFnvPrime;
+        h ^= h >> 32;
+    }
+    for (; i < len; ++i) h = (h ^ (unsigned char)data[i]) * kFnvPrime;
+    return mix(h ^ len);
+}
+
+std::uint64_t hash_combine(std::uint64_t seed, std::uint64_t value) {
+    return mix(seed + 0x9e3779b97f4a7c15ULL + value);
+}
+
+std::uint64_t hash_double(double d) {
+    if (d == 0.0) d = 0.0; // -0.0 == 0.0
+    std::uint64_t bits;
+    std::memcpy(&bits, &d, sizeof bits);
+    return bits;
+}
+
+std::uint64_t hash_tree(const Node& n, AliasHashes& aliases) {
+    std::uint64_t h = mix(n.data.index() + 1);
+    if (n.is_alias()) {
+        // Targets are shared by every alias naming them and may hold aliases
+        // themselves, so each one is hashed once per pass
+        const Node* target = &n.as_alias();
+        auto it = aliases.find(target);
+        if (it == aliases.end()) {
+            std::uint64_t th = hash_tree(*target, aliases);
+            it = aliases.emplace(target, th).first;
+        }
+        h = hash_combine(h, it->second);
+    } else if (n.is_bool()) {
+        h = hash_combine(h, n.as_bool());
+    } else if (std::holds_alternative<int>(n.data)) {
+        h = hash_combine(h, (std::uint64_t)(std::int64_t)std::get<int>(n.data));
+    } else if (std::holds_alternative<double>(n.data)) {
+        h = hash_combine(h, hash_double(std::get<double>(n.data)));
+    } else if (n.is_string()) {
+        const std::string& s = n.as_string();
+        h = hash_bytes(s.data(), s.size(), h);
+    } else if (n.is_sequence()) {
+        for (const Node& item : n.as_sequence()) h = hash_combine(h, hash_tree(item, aliases));
+    } else if (n.is_mapping()) {
+        for (const auto& kv : n.as_mapping()) {
+            h = hash_combine(h, hash_bytes(kv.first.data(), kv.first.size(), 0));
+            h = hash_combine(h, hash_tree(kv.second, aliases));
+        }
+    }
+    return h;
+}
+
+std::uint64_t Node::hash() const {
+    AliasHashes aliases;
+    return hash_tree(*this, aliases);
+}
+
+} // namespace yamln
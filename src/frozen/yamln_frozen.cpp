@@ -0,0 +1,315 @@
+#include "yamln_frozen.h"
+#include "../diff/yamln_diff.h"
+#include <algorithm>
+#include <cctype>
+#include <iterator>
+#include <stdexcept>
+
+namespace yamln {
+
+namespace {
+
+std::uint64_t mapping_entry_hash(const std::string& key, const FrozenNode& value) {
+    return hash_combine(hash_bytes(key.data(), key.size(), 0), value.hash());
+}
+
+std::uint64_t sequence_entry_hash(size_t index, const FrozenNode& value) {
+    return hash_combine(hash_combine(0x5e9, index), value.hash());
+}
+
+} // namespace
+
+FrozenNode make_frozen(std::shared_ptr<FrozenValue> value) {
+    const auto& data = value->data;
+    std::uint64_t h = hash_combine(0xf20, data.index());
+    if (std::holds_alternative<bool>(data)) {
+        h = hash_combine(h, std::get<bool>(data));
+    } else if (std::holds_alternative<int>(data)) {
+        h = hash_combine(h, (std::uint64_t)(std::int64_t)std::get<int>(data));
+    } else if (std::holds_alternative<double>(data)) {
+        h = hash_combine(h, hash_double(std::get<double>(data)));
+    } else if (std::holds_alternative<std::string>(data)) {
+        const std::string& s = std::get<std::string>(data);
+        h = hash_bytes(s.data(), s.size(), h);
+    } else if (std::holds_alternative<FrozenSequence>(data)) {
+        h = hash_combine(h, std::get<FrozenSequence>(data).hash());
+    } else if (std::holds_alternative<FrozenMapping>(data)) {
+        h = hash_combine(h, std::get<FrozenMapping>(data).hash());
+    }
+    value->hash = h;
+    return FrozenNode(std::move(value));
+}
+
+FrozenNode freeze_node(const Node& node, FrozenAnchors& anchors) {
+    if (node.is_alias()) return freeze_node(node.as_alias(), anchors);
+
+    if (node.anchor) {
+        auto it = anchors.find(*node.anchor);
+        if (it != anchors.end() && (it->second.first == &node || *it->second.first == node))
+            return it->second.second;
+    }
+
+    if (node.is_null() && !node.anchor) return FrozenNode();
+
+    auto value = std::make_shared<FrozenValue>();
+    if (node.is_sequence()) {
+        std::vector<FrozenNode> items;
+        items.reserve(node.as_sequence().size());
+        for (const Node& item : node.as_sequence()) items.push_back(freeze_node(item, anchors));
+        value->data = FrozenSequence(std::move(items));
+    } else if (node.is_mapping()) {
+        // Mapping iterates in key order, as FrozenMapping expects
+        std::vector<std::pair<std::string, FrozenNode>> entries;
+        entries.reserve(node.as_mapping().size());
+        for (const auto& kv : node.as_mapping())
+            entries.emplace_back(kv.first, freeze_node(kv.second, anchors));
+        value->data = FrozenMapping(std::move(entries));
+    } else if (node.is_bool()) {
+        value->data = node.as_bool();
+    } else if (std::holds_alternative<int>(node.data)) {
+        value->data = std::get<int>(node.data);
+    } else if (std::holds_alternative<double>(node.data)) {
+        value->data = std::get<double>(node.data);
+    } else if (node.is_string()) {
+        value->data = node.as_string();
+    }
+
+    FrozenNode frozen = make_frozen(std::move(value));
+    if (node.anchor) anchors[*node.anchor] = {&node, frozen};
+    return frozen;
+}
+
+Path resolve_dotted_path(const FrozenNode& root, const std::string& path) {
+    Path out;
+    const FrozenNode* cur = &root;
+    size_t start = 0;
+    while (start <= path.size()) {
+        size_t end = path.find('.', start);
+        if (end == std::string::npos) end = path.size();
+        std::string seg = path.substr(start, end - start);
+
+        bool numeric = !seg.empty();
+        for (char c : seg) {
+            if (!std::isdigit((unsigned char)c)) { numeric = false; break; }
+        }
+
+        if (numeric && cur && cur->is_sequence()) {
+            size_t index = std::stoul(seg);
+            out.emplace_back(index);
+            cur = index < cur->as_sequence().size() ? &cur->as_sequence()[index] : nullptr;
+        } else {
+            out.emplace_back(seg);
+            cur = cur && cur->is_mapping() ? cur->as_mapping().find(seg) : nullptr;
+        }
+        start = end + 1;
+    }
+    return out;
+}
+
+FrozenNode::FrozenNode() {
+    static const FrozenNode null_node = make_frozen(std::make_shared<FrozenValue>());
+    value_ = null_node.value_;
+}
+
+FrozenNode::FrozenNode(const Node& n) {
+    FrozenAnchors anchors;
+    value_ = freeze_node(n, anchors).value_;
+}
+
+const FrozenNode& FrozenNode::operator[](const std::string& key) const {
+    if (!is_mapping()) throw std::runtime_error("Node is not a mapping");
+    return as_mapping().at(key);
+}
+
+const FrozenNode& FrozenNode::operator[](size_t index) const {
+    if (!is_sequence()) throw std::runtime_error("Node is not a sequence");
+    return as_sequence().at(index);
+}
+
+FrozenNode FrozenNode::with(const std::string& path, const Node& value) const {
+    return with(resolve_dotted_path(*this, path), value);
+}
+
+FrozenNode FrozenNode::with(const Path& path, const Node& value) const {
+    return with_at(path, 0, FrozenNode(value));
+}
+
+FrozenNode FrozenNode::with_at(const Path& path, size_t depth, const FrozenNode& value) const {
+    if (depth == path.size()) return value;
+
+    // Only this node and the chunk holding the child are copied; siblings and
+    // the other chunks are shared
+    auto out = std::make_shared<FrozenValue>();
+    const PathSegment& seg = path[depth];
+    if (std::holds_alternative<std::string>(seg)) {
+        const std::string& key = std::get<std::string>(seg);
+        static const FrozenMapping empty;
+        const FrozenMapping& map = is_mapping() ? as_mapping() : empty;
+        const FrozenNode* child = map.find(key);
+        out->data = map.with(key, (child ? *child : FrozenNode()).with_at(path, depth + 1, value));
+    } else {
+        size_t index = std::get<size_t>(seg);
+        static const FrozenSequence empty;
+        const FrozenSequence& seq = is_sequence() ? as_sequence() : empty;
+        FrozenNode child = index < seq.size() ? seq[index] : FrozenNode();
+        out->data = seq.with(index, child.with_at(path, depth + 1, value));
+    }
+    return make_frozen(std::move(out));
+}
+
+Node FrozenNode::thaw() const {
+    if (is_sequence()) {
+        Sequence seq;
+        seq.reserve(as_sequence().size());
+        for (const FrozenNode& item : as_sequence()) seq.push_back(item.thaw());
+        return Node(seq);
+    }
+    if (is_mapping()) {
+        Mapping map;
+        for (const auto& kv : as_mapping()) map.emplace_hint(map.end(), kv.first, kv.second.thaw());
+        return Node(map);
+    }
+    if (is_bool()) return Node(as_bool());
+    if (std::holds_alternative<int>(value_->data)) return Node(std::get<int>(value_->data));
+    if (std::holds_alternative<double>(value_->data)) return Node(std::get<double>(value_->data));
+    if (is_string()) return Node(as_string());
+    return Node(nullptr);
+}
+
+bool FrozenNode::operator==(const FrozenNode& other) const {
+    if (same_as(other)) return true;
+    if (hash() != other.hash()) return false;
+    return value_->data == other.value_->data;
+}
+
+namespace {
+
+// Power of two at least sqrt(n), so index and chunks stay about equally long
+size_t chunk_target(size_t n, size_t min_chunk) {
+    size_t c = min_chunk;
+    while (c * c < n) c *= 2;
+    return c;
+}
+
+bool key_less(const std::pair<std::string, FrozenNode>& entry, const std::string& key) {
+    return entry.first < key;
+}
+
+// Chunk that holds `key` or would receive it: the last one starting at or before it
+template <typename Chunks>
+size_t chunk_for_key(const Chunks& chunks, const std::string& key) {
+    auto it = std::upper_bound(chunks.begin(), chunks.end(), key,
+                               [](const std::string& k, const auto& chunk) { return k < chunk->front().first; });
+    return it == chunks.begin() ? 0 : (size_t)(it - chunks.begin()) - 1;
+}
+
+} // namespace
+
+FrozenMapping::FrozenMapping(std::vector<std::pair<std::string, FrozenNode>> entries) {
+    size_ = entries.size();
+    for (const auto& kv : entries) hash_ += mapping_entry_hash(kv.first, kv.second);
+    size_t chunk = chunk_target(size_, kMinChunk);
+    for (size_t i = 0; i < entries.size(); i += chunk) {
+        auto part = std::make_shared<Chunk>(std::make_move_iterator(entries.begin() + i),
+                                            std::make_move_iterator(entries.begin() + std::min(i + chunk, entries.size())));
+        chunks_.push_back(std::move(part));
+    }
+}
+
+const FrozenNode* FrozenMapping::find(const std::string& key) const {
+    if (chunks_.empty()) return nullptr;
+    const Chunk& chunk = *chunks_[chunk_for_key(chunks_, key)];
+    auto it = std::lower_bound(chunk.begin(), chunk.end(), key, key_less);
+    return it != chunk.end() && it->first == key ? &it->second : nullptr;
+}
+
+const FrozenNode& FrozenMapping::at(const std::string& key) const {
+    if (const FrozenNode* node = find(key)) return *node;
+    throw std::out_of_range("FrozenMapping has no key '" + key + "'");
+}
+
+FrozenMapping FrozenMapping::with(const std::string& key, FrozenNode value) const {
+    FrozenMapping out = *this;
+    if (out.chunks_.empty()) {
+        out.hash_ = mapping_entry_hash(key, value);
+        out.chunks_.push_back(std::make_shared<Chunk>(1, std::make_pair(key, std::move(value))));
+        out.size_ = 1;
+        return out;
+    }
+
+    size_t ci = chunk_for_key(out.chunks_, key);
+    auto chunk = std::make_shared<Chunk>(*out.chunks_[ci]);
+    auto it = std::lower_bound(chunk->begin(), chunk->end(), key, key_less);
+    out.hash_ += mapping_entry_hash(key, value);
+    if (it != chunk->end() && it->first == key) {
+        out.hash_ -= mapping_entry_hash(key, it->second);
+        it->second = std::move(value);
+    } else {
+        chunk->emplace(it, key, std::move(value));
+        ++out.size_;
+    }
+
+    // Split a chunk that outgrew the mapping so updates stay O(sqrt(size))
+    if (chunk->size() > 2 * chunk_target(out.size_, kMinChunk)) {
+        size_t half = chunk->size() / 2;
+        auto upper = std::make_shared<Chunk>(std::make_move_iterator(chunk->begin() + half),
+                                             std::make_move_iterator(chunk->end()));
+        chunk->resize(half);
+        out.chunks_.insert(out.chunks_.begin() + ci + 1, std::move(upper));
+    }
+    out.chunks_[ci] = std::move(chunk);
+    return out;
+}
+
+FrozenSequence::FrozenSequence(std::vector<FrozenNode> items) {
+    size_ = items.size();
+    for (size_t i = 0; i < items.size(); ++i) hash_ += sequence_entry_hash(i, items[i]);
+    chunk_ = chunk_target(size_, kMinChunk);
+    for (size_t i = 0; i < items.size(); i += chunk_) {
+        auto part = std::make_shared<Chunk>(std::make_move_iterator(items.begin() + i),
+                                            std::make_move_iterator(items.begin() + std::min(i + chunk_, items.size())));
+        chunks_.push_back(std::move(part));
+    }
+}
+
+const FrozenNode& FrozenSequence::at(size_t index) const {
+    if (index >= size_) throw std::out_of_range("FrozenSequence index out of range");
+    return (*this)[index];
+}
+
+FrozenSequence FrozenSequence::with(size_t index, FrozenNode value) const {
+    size_t size = std::max(size_, index + 1);
+    // Growth past what the chunk size was picked for re-chunks the whole
+    // sequence; sizes quadruple between rebuilds, so the cost amortizes
+    if (size > 4 * chunk_ * chunk_) {
+        std::vector<FrozenNode> items(begin(), end());
+        items.resize(size);
+        items[index] = std::move(value);
+        return FrozenSequence(std::move(items));
+    }
+
+    FrozenSequence out = *this;
+    while (out.size_ < size) {
+        std::shared_ptr<Chunk> tail;
+        if (!out.chunks_.empty() && out.chunks_.back()->size() < chunk_) {
+            tail = std::make_shared<Chunk>(*out.chunks_.back());
+            out.chunks_.back() = tail;
+        } else {
+            tail = std::make_shared<Chunk>();
+            out.chunks_.push_back(tail);
+        }
+        size_t add = std::min(chunk_ - tail->size(), size - out.size_);
+        tail->resize(tail->size() + add);
+        for (size_t i = out.size_; i < out.size_ + add; ++i) out.hash_ += sequence_entry_hash(i, FrozenNode());
+        out.size_ += add;
+    }
+
+    auto chunk = std::make_shared<Chunk>(*out.chunks_[index / chunk_]);
+    FrozenNode& slot = (*chunk)[index % chunk_];
+    out.hash_ += sequence_entry_hash(index, value) - sequence_entry_hash(index, slot);
+    slot = std::move(value);
+    out.chunks_[index / chunk_] = std::move(chunk);
+    return out;
+}
+
+} // namespace yamln
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <map>
+#include <string>
+
+#include "../../include/yamln.h"
+
+namespace yamln {
+
+// Frozen anchored nodes by anchor name. The parser stores an anchored node and
+// its alias target as separate copies, so they are matched by name and content.
+using FrozenAnchors = std::map<std::string, std::pair<const Node*, FrozenNode>>;
+
+// Sets the structural hash of a freshly built value and wraps it. Every
+// FrozenValue goes through here, so FrozenNode::hash() can be trusted.
+FrozenNode make_frozen(std::shared_ptr<FrozenValue> value);
+
+FrozenNode freeze_node(const Node& node, FrozenAnchors& anchors);
+Path resolve_dotted_path(const FrozenNode& root, const std::string& path);
+
+} // namespace yamln
@@ -0,0 +1,50 @@
+#include "yamln_frozen.h"
+#include <thread>
+
+namespace yamln {
+
+SnapshotHolder::SnapshotHolder() : SnapshotHolder(FrozenNode()) {}
+
+SnapshotHolder::SnapshotHolder(FrozenNode root) : current_(new Version{std::move(root)}) {}
+
+SnapshotHolder::~SnapshotHolder() {
+    delete current_.load();
+}
+
+FrozenNode SnapshotHolder::load() const {
+    unsigned e = epoch_.load(std::memory_order_acquire) & 1;
+    readers_[e].n.fetch_add(1, std::memory_order_seq_cst);
+    FrozenNode root = current_.load(std::memory_order_seq_cst)->root;
+    readers_[e].n.fetch_sub(1, std::memory_order_release);
+    return root;
+}
+
+void SnapshotHolder::store(FrozenNode root) {
+    std::lock_guard<std::mutex> lock(writer_);
+    publish(std::move(root));
+}
+
+void SnapshotHolder::update(const std::string& path, const Node& value) {
+    std::lock_guard<std::mutex> lock(writer_);
+    publish(current_.load()->root.with(path, value));
+}
+
+// Caller holds writer_
+void SnapshotHolder::publish(FrozenNode root) {
+    Version* old = current_.exchange(new Version{std::move(root)}, std::memory_order_seq_cst);
+    synchronize();
+    delete old;
+}
+
+// Flips the reader epoch twice and drains each counter in turn. A reader that
+// could have seen the old version registered before the exchange, so it is
+// counted in one of the two slots and has left once both reach zero.
+void SnapshotHolder::synchronize() {
+    for (int i = 0; i < 2; ++i) {
+        unsigned e = epoch_.fetch_add(1, std::memory_order_seq_cst);
+        while (readers_[e & 1].n.load(std::memory_order_seq_cst) != 0)
+            std::this_thread::yield();
+    }
+}
+
+} // namespace yamln
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../../include/yamln.h"
+
+namespace yamln {
+
+using AnchorMap = std::map<std::string, NodeRef, std::less<>>;
+
+// Storage salvaged from trees handed back to parse_into(). Strings keep their
+// capacity, sequences their buffers and mapping entries their map nodes, so a
+// document shaped like the previous one is built without calling the allocator.
+struct NodePool {
+    std::vector<std::string> strings;
+    std::vector<Sequence> sequences;
+    std::vector<Mapping::node_type> entries;
+
+    // Anchor table of the current document; entries of earlier documents are
+    // parked in spare_anchors with their targets, ready to be refilled.
+    AnchorMap anchors;
+    std::vector<AnchorMap::node_type> spare_anchors;
+
+    std::string take_string() {
+        if (strings.empty()) return std::string();
+        std::string s = std::move(strings.back());
+        strings.pop_back();
+        s.clear();
+        return s;
+    }
+
+    void give(std::string&& s) {
+        // Short strings live inline and are not worth keeping
+        if (s.capacity() > std::string().capacity()) strings.push_back(std::move(s));
+    }
+
+    Sequence take_sequence() {
+        if (sequences.empty()) return Sequence();
+        Sequence seq = std::move(sequences.back());
+        sequences.pop_back();
+        return seq;
+    }
+
+    // map[key] = value, reusing a parked map node when the key is new.
+    // `key` is left with unspecified contents.
+    void insert(Mapping& map, std::string& key, Node&& value);
+
+    AnchorMap::iterator add_anchor(std::string_view name);
+
+    // Takes apart `node`, which is left null
+    void recycle(Node& node);
+
+    // Starts a new document: parks the anchor table
+    void reset_anchors();
+};
+
+} // namespace yamln
@@ -1,20 +1,30 @@
 #include "yamln_parser.h"
-#include "yamln_parser_error.h"
+#include "yamln_parser_json.h"
+#include "../scan/yamln_scan.h"
+#include <cctype>
 
 namespace yamln {
 
-Parser::Parser(const std::string& src) : src_(src), pos_(0), line_(1), col_(1) {}
+template <bool Build>
+BasicParser<Build>::BasicParser(std::string_view src, NodePool* pool)
+    : src_(src), pos_(0), line_(1), col_(1), pool_(pool),
+      anchors_(pool ? &pool->anchors : &own_anchors_) {}
 
-Node Parser::parse_document() {
+template <bool Build>
+Node BasicParser<Build>::parse_document() {
     skip_document_start();
+    int root_line = line_, root_col = col_;
     Node root = parse_node(0);
+    if (rule_ >= 0) schema_check(root, root_line, root_col);
+    if (!schema_errors_.empty()) throw schema_errors_.front();
     skip_whitespace_and_comments();
     if (pos_ < src_.size() && src_.substr(pos_, 3) == "...")
         pos_ += 3;
     return root;
 }
 
-void Parser::skip_document_start() {
+template <bool Build>
+void BasicParser<Build>::skip_document_start() {
     skip_whitespace_and_comments();
     if (pos_ + 3 <= src_.size() && src_.substr(pos_, 3) == "---") {
         pos_ += 3; col_ += 3;
@@ -23,15 +33,19 @@ void Parser::skip_document_start() {
     }
 }
 
-void Parser::skip_inline_space() {
+template <bool Build>
+void BasicParser<Build>::skip_inline_space() {
     while (!at_end() && (peek() == ' ' || peek() == '\t')) advance();
 }
 
-void Parser::skip_to_eol() {
-    while (!at_end() && peek() != '\n') advance();
+template <bool Build>
+void BasicParser<Build>::skip_to_eol() {
+    const void* nl = std::memchr(src_.data() + pos_, '\n', src_.size() - pos_);
+    advance_to(nl ? static_cast<const char*>(nl) - src_.data() : src_.size());
 }
 
-void Parser::skip_whitespace_and_comments() {
+template <bool Build>
+void BasicParser<Build>::skip_whitespace_and_comments() {
     while (!at_end()) {
         char c = peek();
         if (c == ' ' || c == '\t' || c == '\n' || c == '\r') { advance(); }
@@ -40,7 +54,8 @@ void Parser::skip_whitespace_and_comments() {
     }
 }
 
-void Parser::skip_inline_whitespace_and_comments() {
+template <bool Build>
+void BasicParser<Build>::skip_inline_whitespace_and_comments() {
     while (!at_end()) {
         char c = peek();
         if (c == ' ' || c == '\t') advance();
@@ -49,24 +64,75 @@ void Parser::skip_inline_whitespace_and_comments() {
     }
 }
 
-int Parser::current_indent() const {
+template <bool Build>
+int BasicParser<Build>::current_indent() const {
     int i = 0;
     while (pos_ + i < src_.size() && src_[pos_ + i] == ' ') ++i;
     return i;
 }
 
-std::string Parser::parse_anchor_name() {
-    std::string name;
+template <bool Build>
+std::string_view BasicParser<Build>::parse_anchor_name() {
+    size_t start = pos_;
     while (!at_end() && !std::isspace((unsigned char)peek()) &&
            peek() != ',' && peek() != '[' && peek() != ']' &&
            peek() != '{' && peek() != '}') {
-        name += advance();
+        advance();
     }
-    if (name.empty()) throw ParseError("Empty anchor/alias name", line_, col_);
-    return name;
+    if (pos_ == start) throw ParseError("Empty anchor/alias name", line_, col_);
+    return src_.substr(start, pos_ - start);
+}
+
+template <bool Build>
+Node BasicParser<Build>::resolve_alias(std::string_view name) {
+    if constexpr (Build) {
+        auto it = anchors_->find(name);
+        if (it != anchors_->end()) {
+            if (rule_ >= 0) schema_check_alias(*it->second, line_, col_);
+            return Node(it->second);
+        }
+    } else {
+        if (anchor_names_.count(name)) return Node();
+    }
+    throw ParseError("Unknown alias: *" + std::string(name), line_, col_);
+}
+
+template <bool Build>
+void BasicParser<Build>::define_anchor(std::string_view name, const Node& node) {
+    if constexpr (Build) {
+        auto it = anchors_->find(name);
+        if (it == anchors_->end())
+            it = pool_ ? pool_->add_anchor(name) : anchors_->emplace(std::string(name), nullptr).first;
+        // A target nobody else holds, e.g. one parked from an earlier
+        // document, is overwritten in place
+        if (it->second && it->second.use_count() == 1) *it->second = node;
+        else it->second = std::make_shared<Node>(node);
+    } else {
+        anchor_names_.insert(name);
+    }
+}
+
+template class BasicParser<true>;
+template class BasicParser<false>;
+
+void require_utf8(std::string_view src) {
+    if (validate_utf8(src.data(), src.size())) return;
+    size_t offset = invalid_utf8_offset(src.data(), src.size());
+    int line = 1, col = 1;
+    for (size_t i = 0; i < offset; ++i) {
+        if (src[i] == '\n') { ++line; col = 1; }
+        else ++col;
+    }
+    throw ParseError("Invalid UTF-8 sequence", line, col);
 }
 
 Node parse(const std::string& yaml) {
+    require_utf8(yaml);
+    if (looks_like_json(yaml)) {
+        Node root;
+        JsonParser jp(yaml);
+        if (jp.parse_document(root)) return root;
+    }
     Parser p(yaml);
     return p.parse_document();
 }
@@ -1,16 +1,27 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <map>
+#include <set>
 #include <optional>
+#include <cstring>
 
 #include "../../include/yamln.h"
+#include "../schema/yamln_schema.h"
+#include "yamln_node_pool.h"
 
 namespace yamln {
 
-class Parser {
+// Recursive-descent YAML parser. With Build = false it runs the same grammar
+// and throws the same errors, but keeps no values: every node comes back null
+// and no scalar is copied. validate() uses that mode to check documents
+// without allocating a tree. Given a NodePool, strings, sequences and map
+// entries come from it instead of the allocator (see parse_into()).
+template <bool Build>
+class BasicParser {
 public:
-    explicit Parser(const std::string& src);
+    explicit BasicParser(std::string_view src, NodePool* pool = nullptr);
 
     Node parse_document();
 
@@ -18,7 +29,7 @@ public:
     size_t pos() const { return pos_; }
     int line() const { return line_; }
     int col() const { return col_; }
-    const std::string& src() const { return src_; }
+    std::string_view src() const { return src_; }
     size_t src_size() const { return src_.size(); }
     char src_at(size_t idx) const { return src_[idx]; }
     bool at_end() const { return pos_ >= src_.size(); }
@@ -35,6 +46,18 @@ public:
         return c;
     }
 
+    // Moves to `end` in one step, keeping line and column in sync
+    void advance_to(size_t end) {
+        const char* p = src_.data() + pos_;
+        const char* e = src_.data() + end;
+        while (const void* nl = std::memchr(p, '\n', e - p)) {
+            ++line_; col_ = 1;
+            p = static_cast<const char*>(nl) + 1;
+        }
+        col_ += (int)(e - p);
+        pos_ = end;
+    }
+
     void skip_inline_space();
     void skip_to_eol();
     void skip_whitespace_and_comments();
@@ -43,22 +66,66 @@ public:
     void skip_document_start();
 
     Node parse_node(int indent);
-    std::string parse_anchor_name();
+    std::string_view parse_anchor_name();
 
-    std::map<std::string, NodeRef>& anchors() { return anchors_; }
+    AnchorMap& anchors() { return *anchors_; }
+
+    // Checks the document against a schema while it is parsed
+    void set_schema(const CompiledSchema* schema) { schema_ = schema; rule_ = schema ? 0 : -1; }
 
 private:
-    const std::string& src_;
+    // Schema hooks. rule_ is the rule for the node being parsed, -1 when the
+    // subtree is unconstrained. Containers switch it per child and restore it.
+    // Violations are collected in document order and the first one left is
+    // thrown once the document is parsed: a later duplicate key replaces the
+    // value, and its violations with it, as in parse() followed by check().
+    struct SchemaFrame { std::string_view key; size_t index; };
+    // Violations in the value of one mapping key, [begin, end) of schema_errors_
+    struct SchemaKeyErrors { std::string key; size_t begin, end; };
+
+    const CompiledSchema* schema_ = nullptr;
+    int rule_ = -1;
+    std::vector<SchemaFrame> schema_path_;
+    std::vector<ParseError> schema_errors_;
+
+    void schema_expect(unsigned type);
+    void schema_enter_key(int rule, std::string_view key, int line, int col);
+    void schema_enter_item(int rule, size_t index);
+    void schema_leave(int rule);
+    void schema_check(const Node& value, int line, int col);
+    void schema_check_required(int rule, const Mapping& map);
+    void schema_check_alias(const Node& target, int line, int col);
+    void schema_settle_key(std::vector<SchemaKeyErrors>& keys, const std::string& key, size_t begin);
+    std::string schema_path() const;
+    void schema_fail(const std::string& msg, int line, int col);
+
+    std::string_view src_;
     size_t pos_;
     int line_, col_;
-    std::map<std::string, NodeRef> anchors_;
+    NodePool* pool_;
+    AnchorMap own_anchors_;                   // Build only
+    AnchorMap* anchors_;                      // own_anchors_ or the pool's table
+    std::set<std::string_view> anchor_names_; // validation only
+
+    std::string new_string() { return pool_ ? pool_->take_string() : std::string(); }
+    Sequence new_sequence() { return pool_ ? pool_->take_sequence() : Sequence(); }
+    void release(std::string&& s) { if (pool_) pool_->give(std::move(s)); }
+    void insert(Mapping& map, std::string&& key, Node&& value) {
+        if (!pool_) { map[std::move(key)] = std::move(value); return; }
+        pool_->insert(map, key, std::move(value));
+        pool_->give(std::move(key));
+    }
+
+    Node resolve_alias(std::string_view name);
+    void define_anchor(std::string_view name, const Node& node);
 
     // Scalar parsing
     std::string parse_plain_scalar();
     std::string parse_double_quoted();
+    void parse_escape(std::string& out);
     std::string parse_single_quoted();
     std::string parse_block_scalar(char indicator, int parent_indent);
-    Node coerce_scalar(const std::string& s);
+    Node coerce_scalar(std::string s);
 
     // Flow parsing
     Node parse_flow_scalar(int indent);
@@ -70,6 +137,16 @@ private:
     Node parse_block_mapping(int indent);
 };
 
+using Parser = BasicParser<true>;
+using Validator = BasicParser<false>;
+
+// Throws ParseError at the first malformed UTF-8 sequence
+void require_utf8(std::string_view src);
+
 Node parse(const std::string& yaml);
+Node parse(const std::string& yaml, const Schema& schema);
+std::optional<ParseError> validate(std::string_view yaml);
+std::vector<std::optional<ParseError>> validate_batch(const std::vector<std::string_view>& documents,
+                                                      unsigned threads);
 
 } // namespace yamln
@@ -1,10 +1,13 @@
 #include "yamln_parser.h"
-#include "yamln_parser_error.h"
 
 namespace yamln {
 
-Node Parser::parse_block_sequence(int indent) {
-    Sequence seq;
+template <bool Build>
+Node BasicParser<Build>::parse_block_sequence(int indent) {
+    Sequence seq = new_sequence();
+    int rule = rule_;
+    if (rule >= 0) schema_expect(kTypeSequence);
+    size_t index = 0;
     while (!at_end()) {
         {
             size_t saved = pos_; int sl = line_, sc = col_;
@@ -19,6 +22,9 @@ Node Parser::parse_block_sequence(int indent) {
         if (!at_end() && (peek() == ' ' || peek() == '\t')) advance();
         skip_inline_space();
 
+        if (rule >= 0) schema_enter_item(rule, index);
+        int item_line = line_, item_col = col_;
+        Node item;
         if (!at_end() && (peek() == '\n' || peek() == '\r' || peek() == '#')) {
             skip_inline_whitespace_and_comments();
             if (!at_end() && peek() == '\n') advance();
@@ -26,21 +32,27 @@ Node Parser::parse_block_sequence(int indent) {
             skip_whitespace_and_comments();
             if (at_end() || col_ - 1 <= indent) {
                 pos_ = saved; line_ = sl; col_ = sc;
-                seq.push_back(Node(nullptr));
             } else {
-                seq.push_back(parse_node(col_ - 1));
+                item = parse_node(col_ - 1);
             }
         } else {
-            seq.push_back(parse_node(indent));
+            item = parse_node(indent);
             skip_inline_whitespace_and_comments();
             if (!at_end() && (peek() == '\n' || peek() == '\r')) advance();
         }
+        if (rule >= 0) { schema_check(item, item_line, item_col); schema_leave(rule); }
+        if constexpr (Build) seq.push_back(std::move(item));
+        ++index;
     }
-    return Node(seq);
+    return Node(std::move(seq));
 }
 
-Node Parser::parse_block_mapping(int indent) {
+template <bool Build>
+Node BasicParser<Build>::parse_block_mapping(int indent) {
     Mapping map;
+    int rule = rule_;
+    if (rule >= 0) schema_expect(kTypeMapping);
+    std::vector<SchemaKeyErrors> failed_keys;
     while (!at_end()) {
         {
             size_t saved = pos_; int sl = line_, sc = col_;
@@ -52,6 +64,8 @@ Node Parser::parse_block_mapping(int indent) {
         }
 
         std::string key;
+        size_t key_start = pos_;
+        int key_line = line_, key_col = col_;
         if (peek() == '"') {
             key = parse_double_quoted();
         } else if (peek() == '\'') {
@@ -70,16 +84,26 @@ Node Parser::parse_block_mapping(int indent) {
                 ++p;
             }
             if (!found_colon) break;
-            while (!at_end() && peek() != ':' && peek() != '\n') key += advance();
-            while (!key.empty() && key.back() == ' ') key.pop_back();
+            while (!at_end() && peek() != ':' && peek() != '\n') advance();
+            size_t key_end = pos_;
+            while (key_end > key_start && src_[key_end - 1] == ' ') --key_end;
+            if constexpr (Build) {
+                key = new_string();
+                key.assign(src_.data() + key_start, key_end - key_start);
+            }
         }
 
         skip_inline_space();
-        if (at_end() || peek() != ':')
+        if (at_end() || peek() != ':') {
+            if constexpr (!Build) key.assign(src_.data() + key_start, pos_ - key_start);
             throw ParseError("Expected ':' after key '" + key + "'", line_, col_);
+        }
         advance();
         skip_inline_space();
 
+        size_t first_error = schema_errors_.size();
+        if (rule >= 0) schema_enter_key(rule, key, key_line, key_col);
+        int value_line = line_, value_col = col_;
         Node value;
         if (!at_end() && (peek() == '\n' || peek() == '\r' || peek() == '#')) {
             skip_inline_whitespace_and_comments();
@@ -97,15 +121,22 @@ Node Parser::parse_block_mapping(int indent) {
             skip_inline_whitespace_and_comments();
             if (!at_end() && (peek() == '\n' || peek() == '\r')) advance();
         }
-        map[key] = std::move(value);
+        if (rule >= 0) { schema_check(value, value_line, value_col); schema_leave(rule); }
+        if constexpr (Build) {
+            if (schema_errors_.size() > first_error || !failed_keys.empty())
+                schema_settle_key(failed_keys, key, first_error);
+            insert(map, std::move(key), std::move(value));
+        }
     }
-    return Node(map);
+    if (rule >= 0) schema_check_required(rule, map);
+    return Node(std::move(map));
 }
 
-Node Parser::parse_node(int indent) {
+template <bool Build>
+Node BasicParser<Build>::parse_node(int indent) {
     skip_inline_space();
 
-    std::optional<std::string> anchor_name;
+    std::optional<std::string_view> anchor_name;
     if (!at_end() && peek() == '&') {
         advance();
         anchor_name = parse_anchor_name();
@@ -114,10 +145,7 @@ Node Parser::parse_node(int indent) {
 
     if (!at_end() && peek() == '*') {
         advance();
-        std::string alias = parse_anchor_name();
-        auto it = anchors_.find(alias);
-        if (it == anchors_.end()) throw ParseError("Unknown alias: *" + alias, line_, col_);
-        return Node(it->second);
+        return resolve_alias(parse_anchor_name());
     }
 
     Node result;
@@ -172,12 +200,15 @@ Node Parser::parse_node(int indent) {
         }
     }
 
-    if (anchor_name) {
-        result.anchor = anchor_name;
-        anchors_[*anchor_name] = std::make_shared<Node>(result);
+    if constexpr (Build) {
+        if (anchor_name) result.anchor = std::string(*anchor_name);
     }
+    if (anchor_name) define_anchor(*anchor_name, result);
 
     return result;
 }
 
+template class BasicParser<true>;
+template class BasicParser<false>;
+
 } // namespace yamln
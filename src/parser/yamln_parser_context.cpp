@@ -0,0 +1,77 @@
+#include "yamln_parser.h"
+#include "yamln_parser_json.h"
+
+namespace yamln {
+
+void NodePool::insert(Mapping& map, std::string& key, Node&& value) {
+    auto it = map.lower_bound(key);
+    if (it != map.end() && it->first == key) {
+        recycle(it->second);
+        it->second = std::move(value);
+        return;
+    }
+    if (entries.empty()) {
+        map.emplace_hint(it, std::move(key), std::move(value));
+        return;
+    }
+    Mapping::node_type entry = std::move(entries.back());
+    entries.pop_back();
+    entry.key().swap(key);
+    entry.mapped() = std::move(value);
+    map.insert(it, std::move(entry));
+}
+
+AnchorMap::iterator NodePool::add_anchor(std::string_view name) {
+    if (spare_anchors.empty()) return anchors.emplace(std::string(name), nullptr).first;
+    AnchorMap::node_type entry = std::move(spare_anchors.back());
+    spare_anchors.pop_back();
+    entry.key().assign(name.data(), name.size());
+    return anchors.insert(std::move(entry)).position;
+}
+
+void NodePool::recycle(Node& node) {
+    if (auto* s = std::get_if<std::string>(&node.data)) {
+        give(std::move(*s));
+    } else if (auto* seq = std::get_if<Sequence>(&node.data)) {
+        for (Node& item : *seq) recycle(item);
+        seq->clear();
+        if (seq->capacity()) sequences.push_back(std::move(*seq));
+    } else if (auto* map = std::get_if<Mapping>(&node.data)) {
+        while (!map->empty()) {
+            Mapping::node_type entry = map->extract(map->begin());
+            recycle(entry.mapped());
+            entries.push_back(std::move(entry));
+        }
+    }
+    // Aliases only drop their reference; the target belongs to the anchor table
+    node.data = nullptr;
+    node.anchor.reset();
+}
+
+void NodePool::reset_anchors() {
+    while (!anchors.empty()) spare_anchors.push_back(anchors.extract(anchors.begin()));
+}
+
+ParserContext::ParserContext() : pool_(std::make_unique<NodePool>()) {}
+
+ParserContext::~ParserContext() = default;
+
+void ParserContext::clear() {
+    pool_ = std::make_unique<NodePool>();
+}
+
+void parse_into(ParserContext& ctx, const std::string& yaml, Node& out) {
+    NodePool& pool = *ctx.pool_;
+    pool.recycle(out);
+    pool.reset_anchors();
+    require_utf8(yaml);
+    if (looks_like_json(yaml)) {
+        JsonParser jp(yaml, &pool);
+        if (jp.parse_document(out)) return;
+        pool.recycle(out);
+    }
+    Parser p(yaml, &pool);
+    out = p.parse_document();
+}
+
+} // namespace yamln
@@ -1,10 +1,10 @@
 #include "yamln_parser.h"
-#include "yamln_parser_error.h"
 #include <cassert>
 
 namespace yamln {
 
-Node Parser::parse_flow_scalar(int indent) {
+template <bool Build>
+Node BasicParser<Build>::parse_flow_scalar(int indent) {
     skip_inline_space();
     if (at_end()) return Node(nullptr);
     char c = peek();
@@ -14,60 +14,99 @@ Node Parser::parse_flow_scalar(int indent) {
     if (c == '\'') return Node(parse_single_quoted());
     if (c == '*') {
         advance();
-        std::string alias = parse_anchor_name();
-        auto it = anchors_.find(alias);
-        if (it == anchors_.end()) throw ParseError("Unknown alias: *" + alias, line_, col_);
-        return Node(it->second);
+        return resolve_alias(parse_anchor_name());
     }
-    std::string s;
+    size_t start = pos_;
     while (!at_end() && peek() != ',' && peek() != ']' && peek() != '}' && peek() != '\n') {
-        if (peek() == '#' && (s.empty() || s.back() == ' ')) break;
-        s += advance();
+        if (peek() == '#' && (pos_ == start || src_[pos_ - 1] == ' ')) break;
+        advance();
+    }
+    if constexpr (Build) {
+        size_t end = pos_;
+        while (end > start && src_[end - 1] == ' ') --end;
+        std::string s = new_string();
+        s.assign(src_.data() + start, end - start);
+        return coerce_scalar(std::move(s));
     }
-    while (!s.empty() && s.back() == ' ') s.pop_back();
-    return coerce_scalar(s);
+    return Node();
 }
 
-Node Parser::parse_flow_sequence(int indent) {
+template <bool Build>
+Node BasicParser<Build>::parse_flow_sequence(int indent) {
     assert(peek() == '[');
+    int rule = rule_;
+    if (rule >= 0) schema_expect(kTypeSequence);
     advance();
-    Sequence seq;
+    Sequence seq = new_sequence();
     skip_whitespace_and_comments();
     while (!at_end() && peek() != ']') {
-        seq.push_back(parse_flow_scalar(indent));
+        size_t item_start = pos_;
+        if (rule >= 0) schema_enter_item(rule, seq.size());
+        int item_line = line_, item_col = col_;
+        Node item = parse_flow_scalar(indent);
+        if (rule >= 0) { schema_check(item, item_line, item_col); schema_leave(rule); }
+        if constexpr (Build) seq.push_back(std::move(item));
         skip_whitespace_and_comments();
         if (peek() == ',') { advance(); skip_whitespace_and_comments(); }
+        // A stray '}' ends the item without being consumed; without this
+        // check the loop would never advance
+        if (pos_ == item_start)
+            throw ParseError(std::string("Unexpected '") + peek() + "' in flow sequence", line_, col_);
     }
     if (at_end()) throw ParseError("Unterminated flow sequence", line_, col_);
     advance();
-    return Node(seq);
+    return Node(std::move(seq));
 }
 
-Node Parser::parse_flow_mapping(int indent) {
+template <bool Build>
+Node BasicParser<Build>::parse_flow_mapping(int indent) {
     assert(peek() == '{');
+    int rule = rule_;
+    if (rule >= 0) schema_expect(kTypeMapping);
     advance();
     Mapping map;
+    std::vector<SchemaKeyErrors> failed_keys;
     skip_whitespace_and_comments();
     while (!at_end() && peek() != '}') {
         std::string key;
+        int key_line = line_, key_col = col_;
         if (peek() == '"')       key = parse_double_quoted();
         else if (peek() == '\'') key = parse_single_quoted();
         else {
+            size_t start = pos_;
             while (!at_end() && peek() != ':' && peek() != '}' && peek() != '\n')
-                key += advance();
-            while (!key.empty() && key.back() == ' ') key.pop_back();
+                advance();
+            size_t end = pos_;
+            while (end > start && src_[end - 1] == ' ') --end;
+            if constexpr (Build) {
+                key = new_string();
+                key.assign(src_.data() + start, end - start);
+            }
         }
         skip_inline_space();
         if (peek() != ':') throw ParseError("Expected ':' in flow mapping", line_, col_);
         advance();
         skip_inline_space();
-        map[key] = parse_flow_scalar(indent);
+        size_t first_error = schema_errors_.size();
+        if (rule >= 0) schema_enter_key(rule, key, key_line, key_col);
+        int value_line = line_, value_col = col_;
+        Node value = parse_flow_scalar(indent);
+        if (rule >= 0) { schema_check(value, value_line, value_col); schema_leave(rule); }
+        if constexpr (Build) {
+            if (schema_errors_.size() > first_error || !failed_keys.empty())
+                schema_settle_key(failed_keys, key, first_error);
+            insert(map, std::move(key), std::move(value));
+        }
         skip_whitespace_and_comments();
         if (peek() == ',') { advance(); skip_whitespace_and_comments(); }
     }
     if (at_end()) throw ParseError("Unterminated flow mapping", line_, col_);
     advance();
-    return Node(map);
+    if (rule >= 0) schema_check_required(rule, map);
+    return Node(std::move(map));
 }
 
+template class BasicParser<true>;
+template class BasicParser<false>;
+
 } // namespace yamln
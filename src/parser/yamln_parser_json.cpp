@@ -0,0 +1,223 @@
+#include "yamln_parser_json.h"
+#include "yamln_unicode.h"
+#include "../scan/yamln_scan.h"
+#include <array>
+#include <climits>
+#include <cstdlib>
+
+namespace yamln {
+
+namespace {
+
+enum : unsigned char { kSpace = 1, kDigit = 2 };
+
+constexpr std::array<unsigned char, 256> make_char_class() {
+    std::array<unsigned char, 256> t{};
+    t[' '] = t['\t'] = t['\n'] = t['\r'] = kSpace;
+    for (int c = '0'; c <= '9'; ++c) t[c] |= kDigit;
+    return t;
+}
+
+constexpr std::array<unsigned char, 256> kCharClass = make_char_class();
+
+inline bool is_class(char c, unsigned char cls) { return kCharClass[(unsigned char)c] & cls; }
+
+} // namespace
+
+bool looks_like_json(const std::string& src) {
+    for (char c : src) {
+        if (is_class(c, kSpace)) continue;
+        return c == '{' || c == '[';
+    }
+    return false;
+}
+
+JsonParser::JsonParser(const std::string& src, NodePool* pool)
+    : p_(src.c_str()), end_(src.c_str() + src.size()), pool_(pool) {}
+
+bool JsonParser::parse_document(Node& out) {
+    skip_ws();
+    if (*p_ != '{' && *p_ != '[') return false;
+    if (!parse_value(out)) return false;
+    skip_ws();
+    if (p_ != end_) return false;
+    return true;
+}
+
+void JsonParser::skip_ws() {
+    while (is_class(*p_, kSpace)) ++p_;
+}
+
+bool JsonParser::parse_value(Node& out) {
+    switch (*p_) {
+        case '{': return parse_object(out);
+        case '[': return parse_array(out);
+        case '"': {
+            std::string s = pool_ ? pool_->take_string() : std::string();
+            if (!parse_string(s)) return false;
+            out = Node(std::move(s));
+            return true;
+        }
+        case 't':
+            if (end_ - p_ < 4 || p_[1] != 'r' || p_[2] != 'u' || p_[3] != 'e') return false;
+            p_ += 4; out = Node(true); return true;
+        case 'f':
+            if (end_ - p_ < 5 || p_[1] != 'a' || p_[2] != 'l' || p_[3] != 's' || p_[4] != 'e') return false;
+            p_ += 5; out = Node(false); return true;
+        case 'n':
+            if (end_ - p_ < 4 || p_[1] != 'u' || p_[2] != 'l' || p_[3] != 'l') return false;
+            p_ += 4; out = Node(nullptr); return true;
+        default:
+            return parse_number(out);
+    }
+}
+
+bool JsonParser::parse_string(std::string& out) {
+    ++p_;
+    out.clear();
+    for (;;) {
+        // Copy the run of ordinary characters in one go
+        const char* start = p_;
+        p_ = find_json_escape(p_, end_);
+        out.append(start, p_);
+        if (p_ >= end_) return false;
+
+        char c = *p_++;
+        if (c == '"') return true;
+        if (c != '\\') return false; // raw control character
+
+        switch (*p_++) {
+            case '"':  out += '"';  break;
+            case '\\': out += '\\'; break;
+            case '/':  out += '/';  break;
+            case 'b':  out += '\b'; break;
+            case 'f':  out += '\f'; break;
+            case 'n':  out += '\n'; break;
+            case 'r':  out += '\r'; break;
+            case 't':  out += '\t'; break;
+            case 'u': {
+                auto read_hex4 = [this](std::uint32_t& cp) {
+                    if (end_ - p_ < 4) return false;
+                    cp = 0;
+                    for (int i = 0; i < 4; ++i) {
+                        int v = hex_value(p_[i]);
+                        if (v < 0) return false;
+                        cp = (cp << 4) | (std::uint32_t)v;
+                    }
+                    p_ += 4;
+                    return true;
+                };
+                std::uint32_t cp;
+                if (!read_hex4(cp)) return false;
+                if (cp >= 0xD800 && cp <= 0xDBFF) {
+                    std::uint32_t lo;
+                    if (p_[0] != '\\' || p_[1] != 'u') return false;
+                    p_ += 2;
+                    if (!read_hex4(lo) || lo < 0xDC00 || lo > 0xDFFF) return false;
+                    cp = 0x10000 + ((cp - 0xD800) << 10) + (lo - 0xDC00);
+                } else if (cp >= 0xDC00 && cp <= 0xDFFF) {
+                    return false;
+                }
+                append_utf8(out, cp);
+                break;
+            }
+            default:
+                return false;
+        }
+    }
+}
+
+bool JsonParser::parse_number(Node& out) {
+    const char* start = p_;
+    bool neg = *p_ == '-';
+    if (neg) ++p_;
+    if (!is_class(*p_, kDigit)) return false;
+
+    unsigned long long value = 0; // may wrap on long inputs, checked below
+    const char* digits = p_;
+    if (*p_ == '0') {
+        ++p_;
+    } else {
+        while (is_class(*p_, kDigit)) value = value * 10 + (*p_++ - '0');
+    }
+    size_t ndigits = p_ - digits;
+
+    bool integral = true;
+    if (*p_ == '.') {
+        integral = false;
+        ++p_;
+        if (!is_class(*p_, kDigit)) return false;
+        while (is_class(*p_, kDigit)) ++p_;
+    }
+    if (*p_ == 'e' || *p_ == 'E') {
+        integral = false;
+        ++p_;
+        if (*p_ == '+' || *p_ == '-') ++p_;
+        if (!is_class(*p_, kDigit)) return false;
+        while (is_class(*p_, kDigit)) ++p_;
+    }
+
+    // Same typing as coerce_scalar(): int when it fits, double otherwise
+    if (integral && ndigits <= 10 && value <= (neg ? 0x80000000ULL : (unsigned long long)INT_MAX)) {
+        long long v = static_cast<long long>(value);
+        out = Node(static_cast<int>(neg ? -v : v));
+        return true;
+    }
+    out = Node(std::strtod(start, nullptr));
+    return true;
+}
+
+bool JsonParser::parse_array(Node& out) {
+    ++p_;
+    Sequence seq = pool_ ? pool_->take_sequence() : Sequence();
+    skip_ws();
+    if (*p_ == ']') {
+        ++p_;
+        out = Node(std::move(seq));
+        return true;
+    }
+    for (;;) {
+        seq.emplace_back();
+        if (!parse_value(seq.back())) return false;
+        skip_ws();
+        if (*p_ == ',') { ++p_; skip_ws(); continue; }
+        if (*p_ != ']') return false;
+        ++p_;
+        break;
+    }
+    out = Node(std::move(seq));
+    return true;
+}
+
+bool JsonParser::parse_object(Node& out) {
+    ++p_;
+    Mapping map;
+    skip_ws();
+    if (*p_ == '}') {
+        ++p_;
+        out = Node(std::move(map));
+        return true;
+    }
+    std::string key = pool_ ? pool_->take_string() : std::string();
+    for (;;) {
+        if (*p_ != '"' || !parse_string(key)) return false;
+        skip_ws();
+        if (*p_ != ':') return false;
+        ++p_;
+        skip_ws();
+        Node value;
+        if (!parse_value(value)) return false;
+        if (pool_) pool_->insert(map, key, std::move(value));
+        else map.insert_or_assign(key, std::move(value));
+        skip_ws();
+        if (*p_ == ',') { ++p_; skip_ws(); continue; }
+        if (*p_ != '}') return false;
+        ++p_;
+        break;
+    }
+    if (pool_) pool_->give(std::move(key));
+    out = Node(std::move(map));
+    return true;
+}
+
+} // namespace yamln
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <string>
+
+#include "../../include/yamln.h"
+#include "yamln_node_pool.h"
+
+namespace yamln {
+
+// Parser for documents that are plain JSON. It builds the same tree as Parser
+// but reports failure instead of throwing, so parse() can hand anything it
+// does not accept (comments, unquoted keys, trailing text) to the YAML grammar.
+class JsonParser {
+public:
+    explicit JsonParser(const std::string& src, NodePool* pool = nullptr);
+
+    bool parse_document(Node& out);
+
+private:
+    const char* p_;
+    const char* end_; // src is NUL terminated, so *end_ is always readable
+    NodePool* pool_;
+
+    void skip_ws();
+    bool parse_value(Node& out);
+    bool parse_string(std::string& out);
+    bool parse_number(Node& out);
+    bool parse_array(Node& out);
+    bool parse_object(Node& out);
+};
+
+// True when the first significant character opens a JSON array or object
+bool looks_like_json(const std::string& src);
+
+} // namespace yamln
@@ -1,134 +1,292 @@
 #include "yamln_parser.h"
-#include "yamln_parser_error.h"
+#include "yamln_unicode.h"
+#include "../scan/yamln_scan.h"
 #include <cctype>
 #include <cstdlib>
+#include <cstring>
 #include <cassert>
 
 namespace yamln {
 
-std::string Parser::parse_plain_scalar() {
-    std::string result;
+namespace {
+
+struct BlockScan {
+    size_t stop;       // first byte after the block
+    size_t trailing;   // blank lines not followed by content
+    int newlines;      // '\n' characters consumed
+    size_t line_start; // start of the line holding `stop`
+};
+
+// Splits a block scalar body into lines with memchr and calls
+// emit(blank_lines_before, content, length) for every content line,
+// with the block indentation already removed.
+template <typename Emit>
+BlockScan scan_block_lines(std::string_view src, size_t pos, int parent_indent, Emit&& emit) {
+    const char* s = src.data();
+    size_t n = src.size();
+    int block_indent = -1;
+    BlockScan out{pos, 0, 0, pos};
+
+    while (pos < n) {
+        size_t p = pos;
+        while (p < n && s[p] == ' ') ++p;
+        int ind = (int)(p - pos);
+
+        const char* nl = static_cast<const char*>(std::memchr(s + p, '\n', n - p));
+        size_t eol = nl ? (size_t)(nl - s) : n;
+
+        if (p >= n || s[p] == '\n' || s[p] == '\r') {
+            ++out.trailing;
+            if (p < n && s[p] == '\r' && (p + 1 >= n || s[p + 1] != '\n')) {
+                pos = p + 1; // a lone '\r' ends the blank line
+                continue;
+            }
+            pos = nl ? eol + 1 : n;
+            if (nl) { ++out.newlines; out.line_start = pos; }
+            continue;
+        }
+
+        if (block_indent == -1) {
+            if (ind <= parent_indent) break;
+            block_indent = ind;
+        }
+        if (ind < block_indent) break;
+
+        // A line ends at the first '\r' or '\n'; a lone '\r' starts a new line
+        size_t begin = pos + block_indent;
+        const char* cr = static_cast<const char*>(std::memchr(s + begin, '\r', eol - begin));
+        size_t end = cr ? (size_t)(cr - s) : eol;
+        emit(out.trailing, s + begin, end - begin);
+        out.trailing = 0;
+
+        if (cr) {
+            pos = end + 1;
+            if (pos < n && s[pos] == '\n') { ++pos; ++out.newlines; out.line_start = pos; }
+        } else if (nl) {
+            pos = eol + 1;
+            ++out.newlines;
+            out.line_start = pos;
+        } else {
+            pos = n;
+        }
+    }
+    out.stop = pos;
+    return out;
+}
+
+} // namespace
+
+template <bool Build>
+std::string BasicParser<Build>::parse_plain_scalar() {
+    size_t start = pos_;
+    const char* base = src_.data();
     while (!at_end()) {
+        // Jump to the next byte that can end the scalar, then check its context.
+        // '\n' is one of them, so the skipped bytes stay on this line.
+        size_t stop = find_plain_stop(base + pos_, base + src_.size()) - base;
+        col_ += (int)(stop - pos_);
+        pos_ = stop;
+        if (at_end()) break;
         char c = peek();
         if (c == ':' && (peek(1) == ' ' || peek(1) == '\t' || peek(1) == '\n' || peek(1) == '\0'))
             break;
-        if (c == '#' && !result.empty() && (result.back() == ' ' || result.back() == '\t'))
+        if (c == '#' && pos_ > start && (src_[pos_ - 1] == ' ' || src_[pos_ - 1] == '\t'))
             break;
         if (c == '\n' || c == '\r') break;
         if (c == ',' || c == '}' || c == ']') break;
-        result += advance();
+        advance();
     }
-    while (!result.empty() && (result.back() == ' ' || result.back() == '\t'))
-        result.pop_back();
-    return result;
+    if constexpr (!Build) return std::string();
+    size_t end = pos_;
+    while (end > start && (src_[end - 1] == ' ' || src_[end - 1] == '\t')) --end;
+    std::string s = new_string();
+    s.assign(src_.data() + start, end - start);
+    return s;
 }
 
-std::string Parser::parse_double_quoted() {
+template <bool Build>
+std::string BasicParser<Build>::parse_double_quoted() {
     assert(peek() == '"');
     advance();
-    std::string result;
-    while (!at_end() && peek() != '"') {
-        char c = advance();
-        if (c == '\\') {
-            if (at_end()) throw ParseError("Unterminated escape sequence", line_, col_);
-            char e = advance();
-            switch (e) {
-                case 'n':  result += '\n'; break;
-                case 't':  result += '\t'; break;
-                case 'r':  result += '\r'; break;
-                case '"':  result += '"';  break;
-                case '\\': result += '\\'; break;
-                case '0':  result += '\0'; break;
-                default:   result += '\\'; result += e; break;
-            }
-        } else {
-            result += c;
-        }
+    std::string result = new_string();
+    const char* base = src_.data();
+    const char* end = base + src_.size();
+    for (;;) {
+        // Copy everything up to the next quote or escape in one go
+        const char* stop = find_quote_or_backslash(base + pos_, end);
+        if constexpr (Build) result.append(base + pos_, stop);
+        advance_to(stop - base);
+        if (at_end()) throw ParseError("Unterminated double-quoted string", line_, col_);
+        if (peek() == '"') break;
+        advance();
+        parse_escape(result);
     }
-    if (at_end()) throw ParseError("Unterminated double-quoted string", line_, col_);
     advance();
     return result;
 }
 
-std::string Parser::parse_single_quoted() {
+// Decodes the escape after a backslash into UTF-8
+template <bool Build>
+void BasicParser<Build>::parse_escape(std::string& out) {
+    if (at_end()) throw ParseError("Unterminated escape sequence", line_, col_);
+    int line = line_, col = col_ - 1;
+
+    auto read_hex = [&](int digits) {
+        std::uint32_t cp = 0;
+        for (int i = 0; i < digits; ++i) {
+            int v = at_end() ? -1 : hex_value(peek());
+            if (v < 0) throw ParseError("Invalid hex digit in escape sequence", line_, col_);
+            cp = (cp << 4) | (std::uint32_t)v;
+            advance();
+        }
+        return cp;
+    };
+
+    char e = advance();
+    std::uint32_t cp;
+    switch (e) {
+        case '0':  cp = 0x00; break;
+        case 'a':  cp = 0x07; break;
+        case 'b':  cp = 0x08; break;
+        case 't':
+        case '\t': cp = 0x09; break;
+        case 'n':  cp = 0x0A; break;
+        case 'v':  cp = 0x0B; break;
+        case 'f':  cp = 0x0C; break;
+        case 'r':  cp = 0x0D; break;
+        case 'e':  cp = 0x1B; break;
+        case ' ':  cp = 0x20; break;
+        case '"':  cp = 0x22; break;
+        case '/':  cp = 0x2F; break;
+        case '\\': cp = 0x5C; break;
+        case 'N':  cp = 0x85; break;
+        case '_':  cp = 0xA0; break;
+        case 'L':  cp = 0x2028; break;
+        case 'P':  cp = 0x2029; break;
+        case 'x':  cp = read_hex(2); break;
+        case 'u':
+            cp = read_hex(4);
+            // JSON-style surrogate pairs
+            if (cp >= 0xD800 && cp <= 0xDBFF && peek() == '\\' && peek(1) == 'u') {
+                advance(); advance();
+                std::uint32_t lo = read_hex(4);
+                if (lo < 0xDC00 || lo > 0xDFFF)
+                    throw ParseError("Invalid surrogate pair in escape sequence", line, col);
+                cp = 0x10000 + ((cp - 0xD800) << 10) + (lo - 0xDC00);
+            }
+            break;
+        case 'U':  cp = read_hex(8); break;
+        case '\r':
+        case '\n':
+            // Escaped line break: join with the next line, dropping its indentation
+            if (e == '\r' && peek() == '\n') advance();
+            skip_inline_space();
+            return;
+        default:
+            throw ParseError(std::string("Unknown escape sequence '\\") + e + "'", line, col);
+    }
+    if ((cp >= 0xD800 && cp <= 0xDFFF) || cp > 0x10FFFF)
+        throw ParseError("Escape sequence is not a valid code point", line, col);
+    if constexpr (Build) append_utf8(out, cp);
+}
+
+template <bool Build>
+std::string BasicParser<Build>::parse_single_quoted() {
     assert(peek() == '\'');
     advance();
-    std::string result;
+    std::string result = new_string();
+    const char* base = src_.data();
     while (!at_end()) {
-        char c = advance();
-        if (c == '\'') {
-            if (peek() == '\'') { result += '\''; advance(); }
-            else break;
-        } else {
-            result += c;
-        }
+        const void* q = std::memchr(base + pos_, '\'', src_.size() - pos_);
+        size_t stop = q ? (size_t)(static_cast<const char*>(q) - base) : src_.size();
+        if constexpr (Build) result.append(base + pos_, stop - pos_);
+        advance_to(stop);
+        if (at_end()) break;
+        advance();
+        if (peek() != '\'') break;
+        if constexpr (Build) result += '\'';
+        advance();
     }
     return result;
 }
 
-std::string Parser::parse_block_scalar(char indicator, int parent_indent) {
+template <bool Build>
+std::string BasicParser<Build>::parse_block_scalar(char indicator, int parent_indent) {
     advance();
     char chomp = 'c';
     if (!at_end() && (peek() == '-' || peek() == '+')) chomp = advance();
     while (!at_end() && std::isdigit((unsigned char)peek())) advance();
     skip_inline_whitespace_and_comments();
+    if (!at_end() && peek() == '\r') advance();
     if (!at_end() && peek() == '\n') advance();
 
-    int block_indent = -1;
-    std::string result;
-    std::string trailing_newlines;
-
-    while (!at_end()) {
-        size_t tmp_pos = pos_;
-        int ind = 0;
-        while (tmp_pos < src_.size() && src_[tmp_pos] == ' ') { ++ind; ++tmp_pos; }
-
-        if (tmp_pos >= src_.size() || src_[tmp_pos] == '\n' || src_[tmp_pos] == '\r') {
-            while (!at_end() && peek() != '\n') advance();
-            if (!at_end()) advance();
-            trailing_newlines += '\n';
-            continue;
-        }
-
-        if (block_indent == -1) {
-            if (ind <= parent_indent) break;
-            block_indent = ind;
+    // Folded lines are joined with a space, except next to a more-indented
+    // line, where the line break is kept; blank lines are kept as breaks.
+    // Both passes below use this, so the size from the first is exact.
+    bool folded = indicator == '>';
+    bool first = true, prev_spaced = false;
+    auto separator = [&](size_t blank, const char* content, size_t len, bool& space) {
+        bool spaced = len && (content[0] == ' ' || content[0] == '\t');
+        size_t breaks = blank;
+        space = false;
+        if (folded && !first) {
+            if (prev_spaced || spaced) ++breaks;
+            else space = blank == 0;
         }
-        if (ind < block_indent) break;
-
-        result += trailing_newlines;
-        trailing_newlines.clear();
+        prev_spaced = spaced;
+        first = false;
+        return breaks;
+    };
 
-        for (int i = 0; i < block_indent; ++i) advance();
+    size_t size = 0;
+    BlockScan scan = scan_block_lines(src_, pos_, parent_indent,
+        [&](size_t blank, const char* content, size_t len) {
+            bool space;
+            size += separator(blank, content, len, space) + space + len + !folded;
+        });
 
-        std::string line_content;
-        while (!at_end() && peek() != '\n' && peek() != '\r') line_content += advance();
-        if (!at_end() && peek() == '\r') advance();
-        if (!at_end() && peek() == '\n') advance();
+    if (scan.newlines) { line_ += scan.newlines; col_ = 1 + (int)(scan.stop - scan.line_start); }
+    else col_ += (int)(scan.stop - pos_);
+    size_t body = pos_;
+    pos_ = scan.stop;
+    if constexpr (!Build) return std::string();
 
-        if (indicator == '>') {
-            if (!result.empty() && result.back() != '\n') result += ' ';
-            result += line_content;
-        } else {
-            result += line_content + '\n';
-        }
-    }
+    std::string result = new_string();
+    result.reserve(size + scan.trailing + 1);
+    first = true;
+    prev_spaced = false;
+    scan_block_lines(src_, body, parent_indent,
+        [&](size_t blank, const char* content, size_t len) {
+            bool space;
+            result.append(separator(blank, content, len, space), '\n');
+            if (space) result += ' ';
+            result.append(content, len);
+            if (!folded) result += '\n';
+        });
+    assert(result.size() == size);
 
+    // Literal lines already end in their line break; a folded body gets its
+    // last one here
+    bool has_content = !first;
+    if (folded && has_content) result += '\n';
     if (chomp == '-') {
         while (!result.empty() && result.back() == '\n') result.pop_back();
     } else if (chomp == '+') {
-        result += trailing_newlines;
+        result.append(scan.trailing, '\n');
     } else {
         while (!result.empty() && result.back() == '\n') result.pop_back();
-        result += '\n';
+        if (has_content) result += '\n';
     }
     return result;
 }
 
-Node Parser::coerce_scalar(const std::string& s) {
-    if (s == "null" || s == "~" || s.empty()) return Node(nullptr);
-    if (s == "true"  || s == "True"  || s == "TRUE")  return Node(true);
-    if (s == "false" || s == "False" || s == "FALSE") return Node(false);
+namespace {
+
+// Types a plain scalar. Returns false when it stays a string.
+bool coerce_typed(const std::string& s, Node& out) {
+    if (s == "null" || s == "~" || s.empty()) { out = Node(nullptr); return true; }
+    if (s == "true"  || s == "True"  || s == "TRUE")  { out = Node(true); return true; }
+    if (s == "false" || s == "False" || s == "FALSE") { out = Node(false); return true; }
 
     {
         size_t i = 0;
@@ -138,17 +296,31 @@ Node Parser::coerce_scalar(const std::string& s) {
             if (!std::isdigit((unsigned char)s[j])) { all_digits = false; break; }
         }
         if (all_digits && i < s.size()) {
-            try { return Node(std::stoi(s)); } catch (...) {}
+            try { out = Node(std::stoi(s)); return true; } catch (...) {}
         }
     }
 
     {
         char* end = nullptr;
         double d = std::strtod(s.c_str(), &end);
-        if (end && end != s.c_str() && *end == '\0') return Node(d);
+        if (end && end != s.c_str() && *end == '\0') { out = Node(d); return true; }
     }
 
-    return Node(s);
+    return false;
 }
 
+} // namespace
+
+template <bool Build>
+Node BasicParser<Build>::coerce_scalar(std::string s) {
+    if constexpr (!Build) return Node();
+    Node typed;
+    if (!coerce_typed(s, typed)) return Node(std::move(s));
+    release(std::move(s));
+    return typed;
+}
+
+template class BasicParser<true>;
+template class BasicParser<false>;
+
 } // namespace yamln
@@ -0,0 +1,102 @@
+#include "yamln_parser.h"
+
+namespace yamln {
+
+template <bool Build>
+void BasicParser<Build>::schema_expect(unsigned type) {
+    unsigned types = schema_->rules[rule_].types;
+    if (!(types & type)) schema_fail("expected " + schema_type_names(types), line_, col_);
+}
+
+template <bool Build>
+void BasicParser<Build>::schema_enter_key(int rule, std::string_view key, int line, int col) {
+    schema_path_.push_back({key, 0});
+    rule_ = schema_property(*schema_, rule, key);
+    if (rule_ == kSchemaRejected) schema_fail("key is not allowed", line, col);
+}
+
+template <bool Build>
+void BasicParser<Build>::schema_enter_item(int rule, size_t index) {
+    schema_path_.push_back({std::string_view(), index});
+    rule_ = schema_items(*schema_, rule);
+}
+
+template <bool Build>
+void BasicParser<Build>::schema_leave(int rule) {
+    schema_path_.pop_back();
+    rule_ = rule;
+}
+
+template <bool Build>
+void BasicParser<Build>::schema_check(const Node& value, int line, int col) {
+    if (rule_ < 0) return;
+    if (auto err = check_schema_value(schema_->rules[rule_], value)) schema_fail(*err, line, col);
+}
+
+template <bool Build>
+void BasicParser<Build>::schema_check_required(int rule, const Mapping& map) {
+    if (auto err = check_schema_required(schema_->rules[rule], map)) schema_fail(*err, line_, col_);
+}
+
+template <bool Build>
+std::string BasicParser<Build>::schema_path() const {
+    std::string path;
+    for (const SchemaFrame& f : schema_path_) {
+        if (!path.empty()) path += '.';
+        if (f.key.data()) path += f.key;
+        else path += std::to_string(f.index);
+    }
+    return path;
+}
+
+template <bool Build>
+void BasicParser<Build>::schema_check_alias(const Node& target, int line, int col) {
+    // The target was parsed under its own rule (or none), so everything
+    // nested in it is checked here against the rule of the alias' position
+    std::string path = schema_path();
+    try {
+        check_schema_node(*schema_, rule_, target, path);
+    } catch (const std::runtime_error& e) {
+        schema_errors_.emplace_back(e.what(), line, col);
+    }
+}
+
+// Called after each mapping value that had violations, or once any earlier
+// value of the mapping had some; `keys` lists the values with violations
+template <bool Build>
+void BasicParser<Build>::schema_settle_key(std::vector<SchemaKeyErrors>& keys, const std::string& key,
+                                           size_t begin) {
+    for (auto it = keys.begin(); it != keys.end(); ++it) {
+        if (it->key != key) continue;
+        // The earlier value is replaced, so its violations no longer apply
+        size_t n = it->end - it->begin;
+        schema_errors_.erase(schema_errors_.begin() + it->begin, schema_errors_.begin() + it->end);
+        for (auto later = it + 1; later != keys.end(); ++later) {
+            later->begin -= n;
+            later->end -= n;
+        }
+        keys.erase(it);
+        begin -= n;
+        break;
+    }
+    if (schema_errors_.size() > begin) keys.push_back({key, begin, schema_errors_.size()});
+}
+
+template <bool Build>
+void BasicParser<Build>::schema_fail(const std::string& msg, int line, int col) {
+    std::string path = schema_path();
+    if (path.empty()) path = "<root>";
+    schema_errors_.emplace_back("Schema violation at " + path + ": " + msg, line, col);
+}
+
+template class BasicParser<true>;
+template class BasicParser<false>;
+
+Node parse(const std::string& yaml, const Schema& schema) {
+    require_utf8(yaml);
+    Parser p(yaml);
+    p.set_schema(schema.compiled());
+    return p.parse_document();
+}
+
+} // namespace yamln
@@ -0,0 +1,56 @@
+#include "yamln_parser.h"
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <thread>
+
+namespace yamln {
+
+std::optional<ParseError> validate(std::string_view yaml) {
+    try {
+        require_utf8(yaml);
+        Validator v(yaml);
+        v.parse_document();
+        return std::nullopt;
+    } catch (const ParseError&) {
+    }
+
+    // Rejected input takes the full parse() path so the answer and the error
+    // match it exactly, JSON documents the YAML grammar refuses included.
+    try {
+        parse(std::string(yaml));
+        return std::nullopt;
+    } catch (const ParseError& e) {
+        return e;
+    }
+}
+
+std::vector<std::optional<ParseError>> validate_batch(const std::vector<std::string_view>& documents,
+                                                      unsigned threads) {
+    std::vector<std::optional<ParseError>> results(documents.size());
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    threads = (unsigned)std::min<size_t>(threads, documents.size());
+
+    // validate() only turns ParseError into a result; anything else (e.g.
+    // std::bad_alloc) is carried out of the worker and rethrown here
+    std::atomic<size_t> next{0};
+    std::exception_ptr error;
+    std::atomic<bool> failed{false};
+    auto worker = [&] {
+        try {
+            for (size_t i = next++; i < documents.size() && !failed; i = next++)
+                results[i] = validate(documents[i]);
+        } catch (...) {
+            if (!failed.exchange(true)) error = std::current_exception();
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (unsigned t = 1; t < threads; ++t) pool.emplace_back(worker);
+    worker();
+    for (std::thread& t : pool) t.join();
+    if (error) std::rethrow_exception(error);
+    return results;
+}
+
+} // namespace yamln
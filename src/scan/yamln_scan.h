@@ -0,0 +1,73 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+namespace yamln {
+
+// Byte-scanning kernels behind the parser and serializers. Each instruction
+// set level has its own table, holding the fastest kernel of that level or
+// below for each job; the table is picked once, so the library itself can be
+// built for a portable baseline. AVX2 is the highest level picked by default.
+// The YAMLN_ISA environment variable (scalar, sse4.2, avx2, avx512) selects a
+// level instead, e.g. to compare them in benchmarks, but never one the CPU
+// lacks.
+enum class Isa { Scalar, SSE42, AVX2, AVX512 };
+
+struct ScanKernels {
+    const char* name;
+    // First '"' or '\\' in [p, end), or end
+    const char* (*find_quote_or_backslash)(const char* p, const char* end);
+    // First control character, '"' or '\\' in [p, end), or end
+    const char* (*find_json_escape)(const char* p, const char* end);
+    // First byte that may end a plain scalar (one of ":#\n\r,]}"), or end
+    const char* (*find_plain_stop)(const char* p, const char* end);
+    // True when the bytes are well-formed UTF-8 (no overlong forms,
+    // surrogates or code points above U+10FFFF)
+    bool (*validate_utf8)(const char* data, size_t len);
+};
+
+// Kernels for `isa`, or nullptr when this CPU or build does not have them
+const ScanKernels* scan_kernels(Isa isa);
+
+// Starts on stubs that pick the table on first use and swap it in
+extern std::atomic<const ScanKernels*> g_scan_kernels;
+
+inline const ScanKernels& active_scan_kernels() {
+    return *g_scan_kernels.load(std::memory_order_relaxed);
+}
+
+inline const char* find_quote_or_backslash(const char* p, const char* end) {
+    return active_scan_kernels().find_quote_or_backslash(p, end);
+}
+
+inline const char* find_json_escape(const char* p, const char* end) {
+    return active_scan_kernels().find_json_escape(p, end);
+}
+
+inline const char* find_plain_stop(const char* p, const char* end) {
+    return active_scan_kernels().find_plain_stop(p, end);
+}
+
+inline bool validate_utf8(const char* data, size_t len) {
+    return active_scan_kernels().validate_utf8(data, len);
+}
+
+// Offset of the first byte of the first malformed sequence, or len
+size_t invalid_utf8_offset(const char* data, size_t len);
+
+// Per-level tables, defined in yamln_scan_<level>.cpp on x86
+extern const ScanKernels kScalarKernels;
+#if defined(__x86_64__) || defined(__i386__)
+extern const ScanKernels kSse42Kernels;
+extern const ScanKernels kAvx2Kernels;
+extern const ScanKernels kAvx512Kernels;
+
+// Kernels that higher levels share
+const char* sse42_find_quote_or_backslash(const char* p, const char* end);
+const char* sse42_find_json_escape(const char* p, const char* end);
+const char* sse42_find_plain_stop(const char* p, const char* end);
+bool avx2_validate_utf8(const char* data, size_t len);
+#endif
+
+} // namespace yamln
@@ -0,0 +1,117 @@
+// AVX2 UTF-8 validation: the SSE4.2 algorithm widened to 32 bytes. The byte
+// scans of this level are the SSE4.2 ones, which measured faster: the matches
+// they look for are usually a few bytes away, so wider loads only add setup.
+// See yamln_scan_sse42.cpp for the rules on what may live in these files.
+
+#include "yamln_scan.h"
+#include "yamln_utf8_tables.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#include <immintrin.h>
+#include <cstring>
+
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx2"))), apply_to = function)
+#else
+#pragma GCC push_options
+#pragma GCC target("avx2")
+#endif
+
+namespace yamln {
+
+namespace {
+
+inline __m256i load32(const char* p) {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+}
+
+inline __m256i load_table(const char* table) {
+    return _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(table)));
+}
+
+inline __m256i high_nibbles(__m256i v) {
+    return _mm256_and_si256(_mm256_srli_epi16(v, 4), _mm256_set1_epi8(0x0F));
+}
+
+// The N bytes before each byte of `input`, crossing from `prev_input`
+template <int N>
+inline __m256i prev(__m256i input, __m256i prev_input) {
+    return _mm256_alignr_epi8(input, _mm256_permute2x128_si256(prev_input, input, 0x21), 16 - N);
+}
+
+inline __m256i check_special_cases(__m256i input, __m256i prev1) {
+    __m256i byte_1_high = _mm256_shuffle_epi8(load_table(utf8::kByte1High), high_nibbles(prev1));
+    __m256i byte_1_low = _mm256_shuffle_epi8(load_table(utf8::kByte1Low),
+                                             _mm256_and_si256(prev1, _mm256_set1_epi8(0x0F)));
+    __m256i byte_2_high = _mm256_shuffle_epi8(load_table(utf8::kByte2High), high_nibbles(input));
+    return _mm256_and_si256(_mm256_and_si256(byte_1_high, byte_1_low), byte_2_high);
+}
+
+inline __m256i check_multibyte_lengths(__m256i input, __m256i prev_input, __m256i special) {
+    __m256i is_third = _mm256_subs_epu8(prev<2>(input, prev_input), _mm256_set1_epi8((char)(0xE0 - 0x80)));
+    __m256i is_fourth = _mm256_subs_epu8(prev<3>(input, prev_input), _mm256_set1_epi8((char)(0xF0 - 0x80)));
+    __m256i must_be_cont = _mm256_and_si256(_mm256_or_si256(is_third, is_fourth),
+                                            _mm256_set1_epi8((char)0x80));
+    return _mm256_xor_si256(must_be_cont, special);
+}
+
+inline __m256i is_incomplete(__m256i input) {
+    const __m256i max_value = _mm256_setr_epi8(
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        (char)(0xF0 - 1), (char)(0xE0 - 1), (char)(0xC0 - 1));
+    return _mm256_subs_epu8(input, max_value);
+}
+
+// Members are set by the caller: an implicit constructor would not get the
+// target attribute
+struct Utf8State {
+    __m256i error, prev_input, prev_incomplete;
+};
+
+inline void utf8_step(Utf8State& st, __m256i input) {
+    if (_mm256_movemask_epi8(input) == 0) {
+        st.error = _mm256_or_si256(st.error, st.prev_incomplete);
+        st.prev_incomplete = _mm256_setzero_si256();
+    } else {
+        __m256i special = check_special_cases(input, prev<1>(input, st.prev_input));
+        st.error = _mm256_or_si256(st.error, check_multibyte_lengths(input, st.prev_input, special));
+        st.prev_incomplete = is_incomplete(input);
+    }
+    st.prev_input = input;
+}
+
+} // namespace
+
+bool avx2_validate_utf8(const char* data, size_t len) {
+    Utf8State st;
+    st.error = st.prev_input = st.prev_incomplete = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 32 <= len; i += 32) utf8_step(st, load32(data + i));
+    if (i < len) {
+        alignas(32) char tail[32] = {};
+        std::memcpy(tail, data + i, len - i);
+        utf8_step(st, _mm256_load_si256(reinterpret_cast<const __m256i*>(tail)));
+    }
+    __m256i error = _mm256_or_si256(st.error, st.prev_incomplete);
+    return _mm256_testz_si256(error, error);
+}
+
+const ScanKernels kAvx2Kernels = {
+    "avx2",
+    sse42_find_quote_or_backslash,
+    sse42_find_json_escape,
+    sse42_find_plain_stop,
+    avx2_validate_utf8,
+};
+
+} // namespace yamln
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#else
+#pragma GCC pop_options
+#endif
+
+#endif
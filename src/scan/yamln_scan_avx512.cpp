@@ -0,0 +1,95 @@
+// AVX-512BW kernels: 64 bytes per step, with masked loads covering the tail.
+// UTF-8 validation reuses the AVX2 kernel. Only used when YAMLN_ISA=avx512
+// asks for them (see select_kernels()). See yamln_scan_sse42.cpp for the rules
+// on what may live in these files.
+
+#include "yamln_scan.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#include <immintrin.h>
+#include <cstdint>
+
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx512f,avx512bw"))), apply_to = function)
+#else
+#pragma GCC push_options
+#pragma GCC target("avx512f,avx512bw")
+#endif
+
+namespace yamln {
+
+namespace {
+
+// Calls match(block) on 64-byte blocks, the last one zero-filled past `end`,
+// and returns the first position whose bit is set, or end
+template <typename Match>
+inline const char* scan64(const char* p, const char* end, Match match) {
+    size_t n = end - p;
+    for (size_t i = 0; i < n; i += 64) {
+        std::uint64_t live = n - i >= 64 ? ~0ULL : (1ULL << (n - i)) - 1;
+        __m512i v = _mm512_maskz_loadu_epi8(live, p + i);
+        std::uint64_t hit = match(v) & live;
+        if (hit) return p + i + __builtin_ctzll(hit);
+    }
+    return end;
+}
+
+struct QuoteOrBackslash {
+    std::uint64_t operator()(__m512i v) const {
+        return _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8('"')) |
+               _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8('\\'));
+    }
+};
+
+struct JsonEscape {
+    std::uint64_t operator()(__m512i v) const {
+        return _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8('"')) |
+               _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8('\\')) |
+               _mm512_cmple_epu8_mask(v, _mm512_set1_epi8(0x1F));
+    }
+};
+
+struct PlainStop {
+    std::uint64_t operator()(__m512i v) const {
+        return _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8(':')) |
+               _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8('#')) |
+               _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8('\n')) |
+               _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8('\r')) |
+               _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8(',')) |
+               _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8(']')) |
+               _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8('}'));
+    }
+};
+
+const char* avx512_find_quote_or_backslash(const char* p, const char* end) {
+    return scan64(p, end, QuoteOrBackslash());
+}
+
+const char* avx512_find_json_escape(const char* p, const char* end) {
+    return scan64(p, end, JsonEscape());
+}
+
+const char* avx512_find_plain_stop(const char* p, const char* end) {
+    return scan64(p, end, PlainStop());
+}
+
+} // namespace
+
+const ScanKernels kAvx512Kernels = {
+    "avx512",
+    avx512_find_quote_or_backslash,
+    avx512_find_json_escape,
+    avx512_find_plain_stop,
+    avx2_validate_utf8,
+};
+
+} // namespace yamln
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#else
+#pragma GCC pop_options
+#endif
+
+#endif
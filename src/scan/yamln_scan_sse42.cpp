@@ -0,0 +1,161 @@
+// SSE4.2 kernels. Compiled with the target enabled for this file only and
+// reached through the dispatch table, so nothing here may be inlined into
+// code that runs before the CPU check. Keep standard library templates out of
+// this file for the same reason.
+
+#include "yamln_scan.h"
+#include "yamln_utf8_tables.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#include <immintrin.h>
+#include <cstring>
+
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("sse4.2"))), apply_to = function)
+#else
+#pragma GCC push_options
+#pragma GCC target("sse4.2")
+#endif
+
+namespace yamln {
+
+const char* sse42_find_quote_or_backslash(const char* p, const char* end) {
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    while (end - p >= 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        int mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, quote),
+                                                  _mm_cmpeq_epi8(v, backslash)));
+        if (mask) return p + __builtin_ctz(mask);
+        p += 16;
+    }
+    while (p < end && *p != '"' && *p != '\\') ++p;
+    return p;
+}
+
+const char* sse42_find_json_escape(const char* p, const char* end) {
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i control = _mm_set1_epi8(0x1F);
+    while (end - p >= 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i hit = _mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, backslash));
+        hit = _mm_or_si128(hit, _mm_cmpeq_epi8(_mm_min_epu8(v, control), v));
+        int mask = _mm_movemask_epi8(hit);
+        if (mask) return p + __builtin_ctz(mask);
+        p += 16;
+    }
+    while (p < end && (unsigned char)*p >= 0x20 && *p != '"' && *p != '\\') ++p;
+    return p;
+}
+
+// PCMPESTRI does the set match in one instruction. The explicit-length form
+// is used because a NUL in the input must not end the search.
+const char* sse42_find_plain_stop(const char* p, const char* end) {
+    const __m128i set = _mm_setr_epi8(':', '#', '\n', '\r', ',', ']', '}', 0, 0, 0, 0, 0, 0, 0, 0, 0);
+    while (end - p >= 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        int i = _mm_cmpestri(set, 7, v, 16, _SIDD_UBYTE_OPS | _SIDD_CMP_EQUAL_ANY |
+                                            _SIDD_LEAST_SIGNIFICANT);
+        if (i < 16) return p + i;
+        p += 16;
+    }
+    for (; p < end; ++p) {
+        char c = *p;
+        if (c == ':' || c == '#' || c == '\n' || c == '\r' || c == ',' || c == ']' || c == '}')
+            break;
+    }
+    return p;
+}
+
+namespace {
+
+inline __m128i load_table(const char* table) {
+    return _mm_load_si128(reinterpret_cast<const __m128i*>(table));
+}
+
+inline __m128i high_nibbles(__m128i v) {
+    return _mm_and_si128(_mm_srli_epi16(v, 4), _mm_set1_epi8(0x0F));
+}
+
+inline __m128i check_special_cases(__m128i input, __m128i prev1) {
+    __m128i byte_1_high = _mm_shuffle_epi8(load_table(utf8::kByte1High), high_nibbles(prev1));
+    __m128i byte_1_low = _mm_shuffle_epi8(load_table(utf8::kByte1Low),
+                                          _mm_and_si128(prev1, _mm_set1_epi8(0x0F)));
+    __m128i byte_2_high = _mm_shuffle_epi8(load_table(utf8::kByte2High), high_nibbles(input));
+    return _mm_and_si128(_mm_and_si128(byte_1_high, byte_1_low), byte_2_high);
+}
+
+// Third and fourth bytes of a sequence must be continuations, which the
+// two-byte lookup above flags as kTwoConts; the XOR cancels exactly those.
+inline __m128i check_multibyte_lengths(__m128i input, __m128i prev_input, __m128i special) {
+    __m128i prev2 = _mm_alignr_epi8(input, prev_input, 16 - 2);
+    __m128i prev3 = _mm_alignr_epi8(input, prev_input, 16 - 3);
+    __m128i is_third = _mm_subs_epu8(prev2, _mm_set1_epi8((char)(0xE0 - 0x80)));
+    __m128i is_fourth = _mm_subs_epu8(prev3, _mm_set1_epi8((char)(0xF0 - 0x80)));
+    __m128i must_be_cont = _mm_and_si128(_mm_or_si128(is_third, is_fourth), _mm_set1_epi8((char)0x80));
+    return _mm_xor_si128(must_be_cont, special);
+}
+
+// Non-zero where the last bytes of a block start a sequence that does not fit
+inline __m128i is_incomplete(__m128i input) {
+    const __m128i max_value = _mm_setr_epi8(
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        (char)(0xF0 - 1), (char)(0xE0 - 1), (char)(0xC0 - 1));
+    return _mm_subs_epu8(input, max_value);
+}
+
+// Members are set by the caller: an implicit constructor would not get the
+// target attribute
+struct Utf8State {
+    __m128i error, prev_input, prev_incomplete;
+};
+
+inline void utf8_step(Utf8State& st, __m128i input) {
+    if (_mm_movemask_epi8(input) == 0) {
+        st.error = _mm_or_si128(st.error, st.prev_incomplete);
+        st.prev_incomplete = _mm_setzero_si128();
+    } else {
+        __m128i prev1 = _mm_alignr_epi8(input, st.prev_input, 16 - 1);
+        __m128i special = check_special_cases(input, prev1);
+        st.error = _mm_or_si128(st.error, check_multibyte_lengths(input, st.prev_input, special));
+        st.prev_incomplete = is_incomplete(input);
+    }
+    st.prev_input = input;
+}
+
+bool sse42_validate_utf8(const char* data, size_t len) {
+    Utf8State st;
+    st.error = st.prev_input = st.prev_incomplete = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16)
+        utf8_step(st, _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i)));
+    if (i < len) {
+        alignas(16) char tail[16] = {};
+        std::memcpy(tail, data + i, len - i);
+        utf8_step(st, _mm_load_si128(reinterpret_cast<const __m128i*>(tail)));
+    }
+    __m128i error = _mm_or_si128(st.error, st.prev_incomplete);
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(error, _mm_setzero_si128())) == 0xFFFF;
+}
+
+} // namespace
+
+const ScanKernels kSse42Kernels = {
+    "sse4.2",
+    sse42_find_quote_or_backslash,
+    sse42_find_json_escape,
+    sse42_find_plain_stop,
+    sse42_validate_utf8,
+};
+
+} // namespace yamln
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#else
+#pragma GCC pop_options
+#endif
+
+#endif
@@ -0,0 +1,44 @@
+#include "yamln_scan.h"
+#include <cstdint>
+#include <cstring>
+
+namespace yamln {
+
+size_t invalid_utf8_offset(const char* data, size_t len) {
+    const unsigned char* s = reinterpret_cast<const unsigned char*>(data);
+    size_t i = 0;
+    while (i < len) {
+        // Skip ASCII eight bytes at a time
+        while (i + 8 <= len) {
+            std::uint64_t w;
+            std::memcpy(&w, s + i, 8);
+            if (w & 0x8080808080808080ULL) break;
+            i += 8;
+        }
+        if (i >= len) break;
+
+        unsigned char c = s[i];
+        if (c < 0x80) { ++i; continue; }
+
+        size_t n;
+        if (c >= 0xC2 && c <= 0xDF) n = 2;
+        else if (c >= 0xE0 && c <= 0xEF) n = 3;
+        else if (c >= 0xF0 && c <= 0xF4) n = 4;
+        else return i;
+        if (i + n > len) return i;
+
+        unsigned char c1 = s[i + 1];
+        if ((c1 & 0xC0) != 0x80) return i;
+        if (c == 0xE0 && c1 < 0xA0) return i; // overlong
+        if (c == 0xED && c1 > 0x9F) return i; // surrogate
+        if (c == 0xF0 && c1 < 0x90) return i; // overlong
+        if (c == 0xF4 && c1 > 0x8F) return i; // above U+10FFFF
+        for (size_t k = 2; k < n; ++k) {
+            if ((s[i + k] & 0xC0) != 0x80) return i;
+        }
+        i += n;
+    }
+    return len;
+}
+
+} // namespace yamln
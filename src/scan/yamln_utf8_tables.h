@@ -0,0 +1,61 @@
+#pragma once
+
+// Lookup tables for UTF-8 validation after Keiser and Lemire, "Validating
+// UTF-8 In Less Than One Instruction Per Byte". Each byte is classified by the
+// high and low nibble of its predecessor and its own high nibble; a bit
+// survives the AND of the three lookups only for an invalid pair. Shared by
+// the SSE and AVX2 kernels, which load the 16-byte tables into each lane.
+
+namespace yamln {
+namespace utf8 {
+
+constexpr char kTooShort     = 1 << 0; // lead byte not followed by a continuation
+constexpr char kTooLong      = 1 << 1; // ASCII followed by a continuation
+constexpr char kOverlong3    = 1 << 2;
+constexpr char kTooLarge     = 1 << 3;
+constexpr char kSurrogate    = 1 << 4;
+constexpr char kOverlong2    = 1 << 5;
+constexpr char kTooLarge1000 = 1 << 6;
+constexpr char kOverlong4    = 1 << 6;
+constexpr char kTwoConts     = (char)(1 << 7);
+constexpr char kCarry        = kTooShort | kTooLong | kTwoConts;
+
+alignas(16) constexpr char kByte1High[16] = {
+    kTooLong, kTooLong, kTooLong, kTooLong, kTooLong, kTooLong, kTooLong, kTooLong,
+    kTwoConts, kTwoConts, kTwoConts, kTwoConts,
+    kTooShort | kOverlong2,
+    kTooShort,
+    kTooShort | kOverlong3 | kSurrogate,
+    kTooShort | kTooLarge | kTooLarge1000 | kOverlong4,
+};
+
+alignas(16) constexpr char kByte1Low[16] = {
+    kCarry | kOverlong3 | kOverlong2 | kOverlong4,
+    kCarry | kOverlong2,
+    kCarry,
+    kCarry,
+    kCarry | kTooLarge,
+    kCarry | kTooLarge | kTooLarge1000,
+    kCarry | kTooLarge | kTooLarge1000,
+    kCarry | kTooLarge | kTooLarge1000,
+    kCarry | kTooLarge | kTooLarge1000,
+    kCarry | kTooLarge | kTooLarge1000,
+    kCarry | kTooLarge | kTooLarge1000,
+    kCarry | kTooLarge | kTooLarge1000,
+    kCarry | kTooLarge | kTooLarge1000,
+    kCarry | kTooLarge | kTooLarge1000 | kSurrogate,
+    kCarry | kTooLarge | kTooLarge1000,
+    kCarry | kTooLarge | kTooLarge1000,
+};
+
+alignas(16) constexpr char kByte2High[16] = {
+    kTooShort, kTooShort, kTooShort, kTooShort, kTooShort, kTooShort, kTooShort, kTooShort,
+    kTooLong | kOverlong2 | kTwoConts | kOverlong3 | kTooLarge1000 | kOverlong4,
+    kTooLong | kOverlong2 | kTwoConts | kOverlong3 | kTooLarge,
+    kTooLong | kOverlong2 | kTwoConts | kSurrogate | kTooLarge,
+    kTooLong | kOverlong2 | kTwoConts | kSurrogate | kTooLarge,
+    kTooShort, kTooShort, kTooShort, kTooShort,
+};
+
+} // namespace utf8
+} // namespace yamln
@@ -0,0 +1,192 @@
+#include "yamln_schema.h"
+#include <cstdio>
+#include <stdexcept>
+
+namespace yamln {
+
+namespace {
+
+const struct { const char* name; unsigned mask; } kTypeNames[] = {
+    {"null",    kTypeNull},
+    {"boolean", kTypeBool},
+    {"integer", kTypeInt},
+    {"number",  kTypeInt | kTypeDouble},
+    {"string",  kTypeString},
+    {"array",   kTypeSequence},
+    {"object",  kTypeMapping},
+};
+
+const Node& deref(const Node& n) {
+    return n.is_alias() ? n.as_alias() : n;
+}
+
+unsigned parse_type_name(const Node& alias_or_name) {
+    const Node& name = deref(alias_or_name);
+    // An unquoted `null` in a type list is parsed as a null node
+    if (name.is_null()) return kTypeNull;
+    if (name.is_string()) {
+        for (const auto& t : kTypeNames)
+            if (name.as_string() == t.name) return t.mask;
+    }
+    throw std::runtime_error("Invalid schema: unknown type");
+}
+
+std::string format_bound(double d) {
+    char buf[32];
+    std::snprintf(buf, sizeof buf, "%g", d);
+    return buf;
+}
+
+} // namespace
+
+int compile_schema_rule(const Node& alias_or_desc, CompiledSchema& out) {
+    // Descriptions may share rules through anchors, e.g. `b: *a`
+    const Node& desc = deref(alias_or_desc);
+    if (!desc.is_mapping()) throw std::runtime_error("Invalid schema: rule must be a mapping");
+
+    int index = (int)out.rules.size();
+    out.rules.emplace_back();
+    SchemaRule rule;
+
+    for (const auto& kv : desc.as_mapping()) {
+        const std::string& word = kv.first;
+        const Node& value = deref(kv.second);
+        if (word == "type") {
+            if (value.is_sequence()) {
+                rule.types = 0;
+                for (const Node& t : value.as_sequence()) rule.types |= parse_type_name(t);
+            } else {
+                rule.types = parse_type_name(value);
+            }
+        } else if (word == "properties") {
+            if (!value.is_mapping()) throw std::runtime_error("Invalid schema: properties must be a mapping");
+            for (const auto& prop : value.as_mapping())
+                rule.properties[prop.first] = compile_schema_rule(prop.second, out);
+        } else if (word == "required") {
+            if (!value.is_sequence()) throw std::runtime_error("Invalid schema: required must be a sequence");
+            for (const Node& alias_or_key : value.as_sequence()) {
+                const Node& key = deref(alias_or_key);
+                if (!key.is_string()) throw std::runtime_error("Invalid schema: required keys must be strings");
+                rule.required.push_back(key.as_string());
+            }
+        } else if (word == "additionalProperties") {
+            if (value.is_bool()) rule.additional_properties = value.as_bool();
+            else rule.additional_rule = compile_schema_rule(value, out);
+        } else if (word == "items") {
+            rule.items = compile_schema_rule(value, out);
+        } else if (word == "enum") {
+            if (!value.is_sequence()) throw std::runtime_error("Invalid schema: enum must be a sequence");
+            for (const Node& e : value.as_sequence()) rule.enum_values.push_back(deref(e));
+        } else if (word == "minimum" || word == "maximum") {
+            if (!value.is_number()) throw std::runtime_error("Invalid schema: " + word + " must be a number");
+            (word == "minimum" ? rule.minimum : rule.maximum) = value.as_number();
+        }
+        // Other keywords (title, description, ...) carry no constraint
+    }
+
+    out.rules[index] = std::move(rule);
+    return index;
+}
+
+unsigned schema_type_of(const Node& value) {
+    if (value.is_alias()) return schema_type_of(value.as_alias());
+    return 1u << value.data.index();
+}
+
+std::string schema_type_names(unsigned types) {
+    std::string out;
+    for (const auto& t : kTypeNames) {
+        if ((types & t.mask) != t.mask) continue;
+        if (t.mask == kTypeInt && (types & kTypeDouble)) continue; // reported as number
+        if (!out.empty()) out += " or ";
+        out += t.name;
+    }
+    return out;
+}
+
+int schema_property(const CompiledSchema& schema, int rule, std::string_view key) {
+    if (rule < 0) return -1;
+    const SchemaRule& r = schema.rules[rule];
+    auto it = r.properties.find(key);
+    if (it != r.properties.end()) return it->second;
+    return r.additional_properties ? r.additional_rule : kSchemaRejected;
+}
+
+int schema_items(const CompiledSchema& schema, int rule) {
+    return rule < 0 ? -1 : schema.rules[rule].items;
+}
+
+std::optional<std::string> check_schema_value(const SchemaRule& rule, const Node& value) {
+    const Node& v = value.is_alias() ? value.as_alias() : value;
+    if (!(rule.types & schema_type_of(v)))
+        return "expected " + schema_type_names(rule.types);
+
+    if (!rule.enum_values.empty()) {
+        bool found = false;
+        for (const Node& e : rule.enum_values) {
+            if (e == v) { found = true; break; }
+        }
+        if (!found) return std::string("value is not one of the allowed values");
+    }
+
+    if (v.is_number()) {
+        double d = v.as_number();
+        if (rule.minimum && d < *rule.minimum)
+            return "value is below the minimum of " + format_bound(*rule.minimum);
+        if (rule.maximum && d > *rule.maximum)
+            return "value is above the maximum of " + format_bound(*rule.maximum);
+    }
+    return std::nullopt;
+}
+
+std::optional<std::string> check_schema_required(const SchemaRule& rule, const Mapping& map) {
+    for (const std::string& key : rule.required) {
+        if (!map.count(key)) return "missing required key '" + key + "'";
+    }
+    return std::nullopt;
+}
+
+void check_schema_node(const CompiledSchema& schema, int rule, const Node& value, std::string& path) {
+    if (rule < 0) return;
+    const SchemaRule& r = schema.rules[rule];
+    auto fail = [&](const std::string& msg) {
+        throw std::runtime_error("Schema violation at " + (path.empty() ? std::string("<root>") : path) + ": " + msg);
+    };
+
+    if (auto err = check_schema_value(r, value)) fail(*err);
+    const Node& v = value.is_alias() ? value.as_alias() : value;
+
+    size_t len = path.size();
+    if (v.is_mapping()) {
+        if (auto err = check_schema_required(r, v.as_mapping())) fail(*err);
+        for (const auto& kv : v.as_mapping()) {
+            if (!path.empty()) path += '.';
+            path += kv.first;
+            int child = schema_property(schema, rule, kv.first);
+            if (child == kSchemaRejected) fail("key is not allowed");
+            check_schema_node(schema, child, kv.second, path);
+            path.resize(len);
+        }
+    } else if (v.is_sequence() && r.items >= 0) {
+        const Sequence& seq = v.as_sequence();
+        for (size_t i = 0; i < seq.size(); ++i) {
+            if (!path.empty()) path += '.';
+            path += std::to_string(i);
+            check_schema_node(schema, r.items, seq[i], path);
+            path.resize(len);
+        }
+    }
+}
+
+Schema::Schema(const Node& description) {
+    auto compiled = std::make_shared<CompiledSchema>();
+    compile_schema_rule(description, *compiled);
+    compiled_ = std::move(compiled);
+}
+
+void Schema::check(const Node& root) const {
+    std::string path;
+    check_schema_node(*compiled_, 0, root, path);
+}
+
+} // namespace yamln
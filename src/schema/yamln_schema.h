@@ -0,0 +1,59 @@
+#pragma once
+
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../../include/yamln.h"
+
+namespace yamln {
+
+// One bit per Node alternative, so a rule's accepted types are a mask
+enum SchemaType : unsigned {
+    kTypeNull     = 1u << 0,
+    kTypeBool     = 1u << 1,
+    kTypeInt      = 1u << 2,
+    kTypeDouble   = 1u << 3,
+    kTypeString   = 1u << 4,
+    kTypeSequence = 1u << 5,
+    kTypeMapping  = 1u << 6,
+    kTypeAny      = (1u << 7) - 1
+};
+
+constexpr int kSchemaRejected = -2;
+
+struct SchemaRule {
+    unsigned types = kTypeAny;
+    std::map<std::string, int, std::less<>> properties; // key -> rule index
+    std::vector<std::string> required;
+    bool additional_properties = true;
+    int additional_rule = -1; // rule for keys not in properties
+    int items = -1; // rule for sequence items, -1 when unconstrained
+    std::vector<Node> enum_values;
+    std::optional<double> minimum;
+    std::optional<double> maximum;
+};
+
+// Rules are stored flat and refer to each other by index; rules[0] is the root
+struct CompiledSchema {
+    std::vector<SchemaRule> rules;
+};
+
+int compile_schema_rule(const Node& desc, CompiledSchema& out);
+unsigned schema_type_of(const Node& value);
+std::string schema_type_names(unsigned types);
+
+// Rule for a mapping value or sequence item under `rule`: -1 when the child
+// is unconstrained, kSchemaRejected when additionalProperties forbids the key
+int schema_property(const CompiledSchema& schema, int rule, std::string_view key);
+int schema_items(const CompiledSchema& schema, int rule);
+
+// Describes the first type, enum or range violation, or returns nothing
+std::optional<std::string> check_schema_value(const SchemaRule& rule, const Node& value);
+std::optional<std::string> check_schema_required(const SchemaRule& rule, const Mapping& map);
+
+void check_schema_node(const CompiledSchema& schema, int rule, const Node& value, std::string& path);
+
+} // namespace yamln
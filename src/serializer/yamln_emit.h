@@ -0,0 +1,181 @@
+#pragma once
+
+#include <charconv>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include "../../include/yamln.h"
+#include "../scan/yamln_scan.h"
+
+namespace yamln {
+
+// The YAML emitter behind serialize() and serialize_parallel(). Templated on
+// the output so one copy of the formatting rules serves both passes.
+
+inline bool is_scalar(const Node& node) {
+    return node.is_null() || node.is_bool() || node.is_number() || node.is_string() || node.is_alias();
+}
+
+// Output targets. Text is emitted twice, first into a SizeSink to learn the
+// exact length and then into a BufferSink over storage of that length; both
+// passes run the same code, so the sizes match the bytes exactly.
+struct SizeSink {
+    size_t n = 0;
+    void put(char) { ++n; }
+    void put(const char*, size_t len) { n += len; }
+    void put(const std::string& s) { n += s.size(); }
+    void fill(size_t len) { n += len; }
+};
+
+struct BufferSink {
+    char* p;
+    void put(char c) { *p++ = c; }
+    void put(const char* s, size_t len) { std::memcpy(p, s, len); p += len; }
+    void put(const std::string& s) { put(s.data(), s.size()); }
+    void fill(size_t len) { std::memset(p, ' ', len); p += len; }
+};
+
+// Double-quoted string in which only '"' and '\\' are escaped
+template <typename Sink>
+void emit_quoted(const std::string& s, Sink& out) {
+    out.put('"');
+    const char* p = s.data();
+    const char* end = p + s.size();
+    for (;;) {
+        const char* stop = find_quote_or_backslash(p, end);
+        out.put(p, stop - p);
+        if (stop == end) break;
+        out.put('\\');
+        out.put(*stop);
+        p = stop + 1;
+    }
+    out.put('"');
+}
+
+// Keys that are not identifiers are quoted
+template <typename Sink>
+void emit_key(const std::string& key, Sink& out) {
+    bool quote = key.empty() ||
+                 (!std::isalpha(static_cast<unsigned char>(key[0])) && key[0] != '_');
+    for (size_t i = 0; !quote && i < key.size(); ++i) {
+        char c = key[i];
+        quote = !std::isalnum(static_cast<unsigned char>(c)) && c != '_' && c != '-';
+    }
+    if (quote) emit_quoted(key, out);
+    else out.put(key);
+}
+
+template <typename Sink>
+void emit_scalar(const Node& node, Sink& out) {
+    char buf[32];
+    if (node.is_alias()) {
+        const Node& ref_node = node.as_alias();
+        if (!ref_node.anchor) {
+            throw std::runtime_error("Alias references a node without an anchor");
+        }
+        out.put('*');
+        out.put(*ref_node.anchor);
+    } else if (node.is_null()) {
+        out.put("null", 4);
+    } else if (node.is_bool()) {
+        if (node.as_bool()) out.put("true", 4);
+        else out.put("false", 5);
+    } else if (std::holds_alternative<int>(node.data)) {
+        char* end = std::to_chars(buf, buf + sizeof buf, std::get<int>(node.data)).ptr;
+        out.put(buf, end - buf);
+    } else if (std::holds_alternative<double>(node.data)) {
+        // %g, which is also what a default std::ostream prints
+        int len = std::snprintf(buf, sizeof buf, "%g", std::get<double>(node.data));
+        out.put(buf, len);
+    } else if (node.is_string()) {
+        emit_quoted(node.as_string(), out);
+    } else {
+        throw std::runtime_error("Not a scalar node");
+    }
+}
+
+template <typename Sink>
+void emit_container(const Node& node, Sink& out, int indent);
+
+// Everything after "-" or "key:"
+template <typename Sink>
+void emit_value(const Node& val, Sink& out, int indent) {
+    if (val.anchor) {
+        out.put(" &", 2);
+        out.put(*val.anchor);
+    }
+    if (is_scalar(val)) {
+        out.put(' ');
+        emit_scalar(val, out);
+    } else {
+        out.put('\n');
+        emit_container(val, out, indent + 2);
+    }
+}
+
+template <typename Sink>
+void emit_item(const Node& item, Sink& out, int indent) {
+    out.fill(indent);
+    out.put('-');
+    emit_value(item, out, indent);
+}
+
+template <typename Sink>
+void emit_entry(const Mapping::value_type& kv, Sink& out, int indent) {
+    out.fill(indent);
+    emit_key(kv.first, out);
+    out.put(':');
+    emit_value(kv.second, out, indent);
+}
+
+template <typename Sink>
+void emit_container(const Node& node, Sink& out, int indent) {
+    if (node.is_sequence()) {
+        const Sequence& seq = node.as_sequence();
+        if (seq.empty()) {
+            out.put("[]", 2);
+            return;
+        }
+        bool first = true;
+        for (const Node& item : seq) {
+            if (!first) out.put('\n');
+            first = false;
+            emit_item(item, out, indent);
+        }
+    } else if (node.is_mapping()) {
+        const Mapping& map = node.as_mapping();
+        if (map.empty()) {
+            out.put("{}", 2);
+            return;
+        }
+        bool first = true;
+        for (const auto& kv : map) {
+            if (!first) out.put('\n');
+            first = false;
+            emit_entry(kv, out, indent);
+        }
+    } else {
+        throw std::runtime_error("Not a container node");
+    }
+}
+
+template <typename Sink>
+void emit_root_anchor(const Node& n, Sink& out) {
+    if (!n.anchor) return;
+    out.put('&');
+    out.put(*n.anchor);
+    out.put(is_scalar(n) ? ' ' : '\n');
+}
+
+// The whole document: root anchor, then the scalar or container
+template <typename Sink>
+void emit_document(const Node& n, Sink& out) {
+    emit_root_anchor(n, out);
+    if (is_scalar(n)) emit_scalar(n, out);
+    else emit_container(n, out, 0);
+}
+
+} // namespace yamln
@@ -1,17 +1,17 @@
 #pragma once
 
 #include <string>
-#include <iostream>
 
 #include "../../include/yamln.h"
 
 namespace yamln {
 
-std::string format_key(const std::string& key);
-bool is_scalar(const Node& node);
-void serialize_scalar(const Node& node, std::ostream& os);
-void serialize_container(const Node& node, std::ostream& os, int indent);
+void append_json_string(const std::string& s, std::string& out);
+void append_json_number(double d, std::string& out);
+void serialize_json_node(const Node& node, std::string& out);
 
 std::string serialize(const Node& n);
+std::string serialize_parallel(const Node& n, unsigned threads);
+std::string serialize_json(const Node& n);
 
 } // namespace yamln
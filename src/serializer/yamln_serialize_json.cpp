@@ -0,0 +1,95 @@
+#include "yamln_serialize.h"
+#include "../scan/yamln_scan.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace yamln {
+
+void append_json_string(const std::string& s, std::string& out) {
+    static const char hex[] = "0123456789abcdef";
+    out += '"';
+    const char* p = s.data();
+    const char* end = p + s.size();
+    for (;;) {
+        const char* stop = find_json_escape(p, end);
+        out.append(p, stop);
+        if (stop == end) break;
+        p = stop + 1;
+        unsigned char c = *stop;
+        switch (c) {
+            case '"':  out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n";  break;
+            case '\t': out += "\\t";  break;
+            case '\r': out += "\\r";  break;
+            case '\b': out += "\\b";  break;
+            case '\f': out += "\\f";  break;
+            default:
+                out += "\\u00";
+                out += hex[c >> 4];
+                out += hex[c & 0xF];
+                break;
+        }
+    }
+    out += '"';
+}
+
+void append_json_number(double d, std::string& out) {
+    if (!std::isfinite(d)) {
+        out += "null";
+        return;
+    }
+    // Shortest of %.15g/%.17g that reads back exactly
+    char buf[32];
+    int len = std::snprintf(buf, sizeof buf, "%.15g", d);
+    if (std::strtod(buf, nullptr) != d) len = std::snprintf(buf, sizeof buf, "%.17g", d);
+    out.append(buf, len);
+    // Keep the value a double when it is read back
+    if (!std::strpbrk(buf, ".eE")) out += ".0";
+}
+
+void serialize_json_node(const Node& node, std::string& out) {
+    if (node.is_alias()) {
+        serialize_json_node(node.as_alias(), out);
+    } else if (node.is_null()) {
+        out += "null";
+    } else if (node.is_bool()) {
+        out += node.as_bool() ? "true" : "false";
+    } else if (std::holds_alternative<int>(node.data)) {
+        out += std::to_string(std::get<int>(node.data));
+    } else if (std::holds_alternative<double>(node.data)) {
+        append_json_number(std::get<double>(node.data), out);
+    } else if (node.is_string()) {
+        append_json_string(node.as_string(), out);
+    } else if (node.is_sequence()) {
+        out += '[';
+        bool first = true;
+        for (const Node& item : node.as_sequence()) {
+            if (!first) out += ',';
+            first = false;
+            serialize_json_node(item, out);
+        }
+        out += ']';
+    } else {
+        out += '{';
+        bool first = true;
+        for (const auto& kv : node.as_mapping()) {
+            if (!first) out += ',';
+            first = false;
+            append_json_string(kv.first, out);
+            out += ':';
+            serialize_json_node(kv.second, out);
+        }
+        out += '}';
+    }
+}
+
+std::string serialize_json(const Node& n) {
+    std::string out;
+    serialize_json_node(n, out);
+    return out;
+}
+
+} // namespace yamln
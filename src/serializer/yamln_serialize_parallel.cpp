@@ -0,0 +1,99 @@
+#include "yamln_serialize.h"
+#include "yamln_emit.h"
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <exception>
+#include <thread>
+
+namespace yamln {
+
+namespace {
+
+// Runs body(thread_index) on `threads` threads, the caller included, and
+// rethrows the first exception any of them raised
+template <typename F>
+void run_threads(unsigned threads, F&& body) {
+    std::exception_ptr error;
+    std::atomic<bool> failed{false};
+    auto guarded = [&](unsigned t) {
+        try {
+            body(t);
+        } catch (...) {
+            if (!failed.exchange(true)) error = std::current_exception();
+        }
+    };
+    std::vector<std::thread> pool;
+    for (unsigned t = 1; t < threads; ++t) pool.emplace_back(guarded, t);
+    guarded(0);
+    for (std::thread& t : pool) t.join();
+    if (error) std::rethrow_exception(error);
+}
+
+constexpr size_t kSizeBlock = 64;           // top-level entries per size task
+constexpr size_t kBytesPerThread = 1 << 18; // smallest write share worth a thread
+
+} // namespace
+
+std::string serialize_parallel(const Node& n, unsigned threads) {
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+
+    // Top-level entries are the unit of work; entry i includes the newline
+    // separating it from entry i - 1
+    const Sequence* seq = n.is_sequence() ? &n.as_sequence() : nullptr;
+    std::vector<const Mapping::value_type*> entries;
+    if (n.is_mapping()) {
+        entries.reserve(n.as_mapping().size());
+        for (const auto& kv : n.as_mapping()) entries.push_back(&kv);
+    }
+    size_t count = seq ? seq->size() : entries.size();
+
+    if (count == 0 || threads == 1) return serialize(n);
+
+    auto emit = [&](size_t i, auto& sink) {
+        if (i) sink.put('\n');
+        if (seq) emit_item((*seq)[i], sink, 0);
+        else emit_entry(*entries[i], sink, 0);
+    };
+
+    // Pass 1: exact size of every entry
+    std::vector<size_t> offsets(count + 1);
+    std::atomic<size_t> next{0};
+    size_t blocks = (count + kSizeBlock - 1) / kSizeBlock;
+    run_threads((unsigned)std::min<size_t>(threads, blocks), [&](unsigned) {
+        for (size_t b = next++; b < blocks; b = next++) {
+            size_t end = std::min(count, (b + 1) * kSizeBlock);
+            for (size_t i = b * kSizeBlock; i < end; ++i) {
+                SizeSink size;
+                emit(i, size);
+                offsets[i + 1] = size.n;
+            }
+        }
+    });
+
+    SizeSink head;
+    emit_root_anchor(n, head);
+    offsets[0] = head.n;
+    for (size_t i = 0; i < count; ++i) offsets[i + 1] += offsets[i];
+    size_t total = offsets[count];
+
+    // Pass 2: contiguous runs of entries with about equal byte counts
+    std::string out(total, '\0');
+    char* base = &out[0];
+    BufferSink anchor_sink{base};
+    emit_root_anchor(n, anchor_sink);
+
+    unsigned writers = (unsigned)std::min<size_t>(threads, total / kBytesPerThread + 1);
+    writers = (unsigned)std::min<size_t>(writers, count);
+    run_threads(writers, [&](unsigned t) {
+        size_t lo = std::lower_bound(offsets.begin(), offsets.end() - 1, total / writers * t) - offsets.begin();
+        size_t hi = t + 1 == writers ? count
+            : std::lower_bound(offsets.begin(), offsets.end() - 1, total / writers * (t + 1)) - offsets.begin();
+        BufferSink sink{base + offsets[lo]};
+        for (size_t i = lo; i < hi; ++i) emit(i, sink);
+        assert(sink.p == base + offsets[hi]);
+    });
+    return out;
+}
+
+} // namespace yamln
@@ -0,0 +1,987 @@
+// Regression tests for yamln, run by `meson test -C build`. Each test_*
+// function reports failures through check(); the exit status is the number of
+// failed checks, capped so it stays a valid status. `yamln_test api` and
+// `yamln_test scan` run one group; no argument runs both.
+
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <new>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "../include/yamln.h"
+#include "../src/parser/yamln_parser.h"
+#include "../src/parser/yamln_parser_json.h"
+#include "../src/scan/yamln_scan.h"
+
+// Counts heap bytes for the structural sharing test
+static std::atomic<size_t> g_allocated{0};
+
+void* operator new(size_t size) {
+    g_allocated.fetch_add(size, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+
+namespace {
+
+int g_failures = 0;
+
+void check(bool ok, const char* what, const std::string& detail = std::string()) {
+    if (ok) return;
+    ++g_failures;
+    std::fprintf(stderr, "FAIL: %s%s%s\n", what, detail.empty() ? "" : ": ", detail.c_str());
+}
+
+// Message of the ParseError parse() throws, or empty when it accepts the input
+std::string parse_error(const std::string& yaml) {
+    try {
+        yamln::parse(yaml);
+    } catch (const yamln::ParseError& e) {
+        return e.what();
+    }
+    return std::string();
+}
+
+// Small deterministic generator, so failures reproduce on every platform
+struct Random {
+    std::uint64_t state;
+    explicit Random(std::uint64_t seed) : state(seed) {}
+    std::uint64_t next() {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return state;
+    }
+    size_t below(size_t n) { return (size_t)(next() % n); }
+};
+
+// Documents assembled from YAML fragments, most of them malformed, followed
+// by single-byte mutations of well-formed documents
+std::vector<std::string> make_fuzz_corpus() {
+    static const char* const fragments[] = {
+        "a", ": ", "- ", "\n", "  ", "\"x\\ty\"", "'q''r'", "[", "]", "{", "}", ", ",
+        "&an ", "*an", "#c", "|\n", ">-\n", "1", "2.5", "true", "~", "key: val\n",
+        "  - 3\n", "\"k\": 1", "\r\n", ":", "-", "\\", "\"", "\xC3\xA9", "\t", "null",
+        "...", "---\n",
+    };
+    static const char* const bases[] = {
+        "a: 1\nb:\n  - x\n  - &r {p: [1, 2], q: 'z'}\nc: *r\nd: |\n  l1\n  l2\ne: \"s\\n\"\n",
+        "{\"a\": [1, {\"b\": null}], \"c\": \"d\"}",
+    };
+    static const char mutations[] = "[]{},:-#&*'\"\n |>\\";
+
+    Random rng(0x9E3779B97F4A7C15ULL);
+    std::vector<std::string> docs;
+    for (int i = 0; i < 8000; ++i) {
+        std::string doc;
+        for (size_t n = 1 + rng.below(25); n > 0; --n)
+            doc += fragments[rng.below(sizeof fragments / sizeof fragments[0])];
+        docs.push_back(doc);
+    }
+    for (const char* base : bases) {
+        for (int i = 0; i < 2000; ++i) {
+            std::string doc = base;
+            for (size_t n = rng.below(4); n > 0; --n) {
+                size_t at = rng.below(doc.size());
+                char c = mutations[rng.below(sizeof mutations - 1)];
+                switch (rng.below(3)) {
+                    case 0: doc[at] = c; break;
+                    case 1: doc.insert(doc.begin() + at, c); break;
+                    default: doc.erase(at, 1); break;
+                }
+            }
+            docs.push_back(doc);
+        }
+    }
+    return docs;
+}
+
+// A '}' inside a flow sequence was neither consumed nor rejected, so the
+// item loop spun forever; it must be a ParseError in both modes
+void test_stray_brace_in_flow_sequence() {
+    for (const char* yaml : {"[a, }]", "[}", "k: [1, }, 2]\n", "- [x }\n"}) {
+        check(!parse_error(yaml).empty(), "parse() rejects a stray '}' in a flow sequence", yaml);
+        check(yamln::validate(yaml).has_value(), "validate() rejects a stray '}' in a flow sequence", yaml);
+    }
+}
+
+// validate() must accept exactly what parse() accepts and report the same error
+void test_validate_matches_parse() {
+    std::vector<std::string> docs = make_fuzz_corpus();
+    std::vector<std::string_view> views(docs.begin(), docs.end());
+    std::vector<std::optional<yamln::ParseError>> batch = yamln::validate_batch(views, 4);
+    check(batch.size() == docs.size(), "validate_batch() returns one result per document");
+
+    size_t rejected = 0;
+    for (size_t i = 0; i < docs.size() && i < batch.size(); ++i) {
+        std::string expected = parse_error(docs[i]);
+        std::optional<yamln::ParseError> single = yamln::validate(docs[i]);
+        std::string got = single ? single->what() : "";
+        std::string got_batch = batch[i] ? batch[i]->what() : "";
+        check(got == expected, "validate() agrees with parse()", docs[i] + " -> " + got + " | " + expected);
+        check(got_batch == expected, "validate_batch() agrees with parse()", docs[i]);
+        if (!expected.empty()) ++rejected;
+    }
+    // Keeps the corpus honest: it has to exercise both outcomes
+    check(rejected > docs.size() / 10 && rejected < docs.size(), "fuzz corpus mixes valid and invalid input");
+}
+
+// Edits that bypass operator[] must still be seen by operator==, hash() and diff()
+void test_direct_edits_are_compared() {
+    yamln::Node a = yamln::parse("x: 1");
+    a.hash();
+    std::get<yamln::Mapping>(a.data)["x"].data = 2;
+    yamln::Node b = yamln::parse("x: 2");
+    check(a == b, "operator== sees a direct assignment to data");
+    check(a.hash() == b.hash(), "hash() sees a direct assignment to data");
+    check(yamln::diff(b, a).empty(), "diff() of equal trees is empty");
+
+    // A reference kept across hash() on the parent
+    yamln::Node r = yamln::parse("a: {b: 1}\nc: [1, 2]");
+    yamln::Node before = r;
+    yamln::Node& child = r["a"];
+    r.hash();
+    child["b"] = 2;
+    yamln::Patch patch = yamln::diff(before, r);
+    check(patch.size() == 1 && patch[0].kind == yamln::PatchOp::Kind::Change,
+          "diff() reports an edit made through a kept reference");
+    yamln::apply_patch(before, patch);
+    check(before == r, "apply_patch() reproduces the edited tree");
+
+    yamln::Node to = yamln::parse("a: {b: 2, d: x}\nc: [1]\ne: true");
+    patch = yamln::diff(r, to);
+    check(patch.size() == 3, "diff() lists one op per added or removed path",
+          std::to_string(patch.size()));
+    yamln::apply_patch(r, patch);
+    check(r == to, "apply_patch() turns `from` into `to`");
+}
+
+// Each level aliases the previous one three times, so hashing that followed
+// every alias without memoizing targets would take 3^40 steps
+std::string make_nested_aliases(int levels, const char* leaf) {
+    std::string doc = std::string("l0: &a0\n  v: ") + leaf + "\n";
+    for (int i = 1; i < levels; ++i) {
+        std::string prev = "*a" + std::to_string(i - 1);
+        doc += "l" + std::to_string(i) + ": &a" + std::to_string(i) + "\n";
+        for (const char* key : {"x", "y", "z"}) doc += std::string("  ") + key + ": " + prev + "\n";
+    }
+    return doc;
+}
+
+void test_nested_aliases_hash_once() {
+    yamln::Node a = yamln::parse(make_nested_aliases(40, "1"));
+    yamln::Node b = yamln::parse(make_nested_aliases(40, "1"));
+    yamln::Node c = yamln::parse(make_nested_aliases(40, "2"));
+    check(a.hash() == b.hash(), "equal documents with nested aliases hash equal");
+    check(a.hash() != c.hash(), "a change under nested aliases changes the hash");
+    check(yamln::diff(a, b).empty(), "diff() of equal documents with nested aliases is empty");
+    check(!yamln::diff(a, c).empty(), "diff() sees a change under nested aliases");
+    check(yamln::diff(yamln::FrozenNode(a), yamln::FrozenNode(b)).empty(),
+          "frozen diff() of equal documents with nested aliases is empty");
+}
+
+bool same_patch(const yamln::Patch& a, const yamln::Patch& b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i)
+        if (a[i].kind != b[i].kind || a[i].path != b[i].path || a[i].value != b[i].value) return false;
+    return true;
+}
+
+// Hashes kept up to date by with() must match a fresh freeze, and the frozen
+// diff must list the same edits as the Node one
+void test_frozen_diff_matches_node_diff() {
+    Random rng(26);
+    yamln::FrozenNode root(yamln::parse("a: {b: 1, c: [1, 2, 3]}\nd: x\n"));
+    for (int i = 0; i < 400; ++i) {
+        yamln::FrozenNode next = root;
+        for (size_t n = rng.below(4); n > 0; --n) {
+            yamln::Node value = rng.below(3) ? yamln::Node((int)rng.below(4)) : yamln::parse("{p: [1], q: z}");
+            std::string path = rng.below(2) ? "a.k" + std::to_string(rng.below(40))
+                                            : "a.c." + std::to_string(rng.below(60));
+            next = next.with(path, value);
+        }
+        check(next.hash() == yamln::FrozenNode(next.thaw()).hash(), "with() keeps hash() equal to a fresh freeze");
+        yamln::Node from = root.thaw();
+        yamln::Patch patch = yamln::diff(root, next);
+        check(same_patch(patch, yamln::diff(from, next.thaw())), "frozen diff() matches the Node diff()");
+        yamln::apply_patch(from, patch);
+        check(from == next.thaw(), "frozen diff() turns `from` into `to`");
+        root = next;
+    }
+}
+
+// Outcome of parse(yaml, schema) and of parse() followed by Schema::check():
+// empty when accepted, otherwise the violation without its position
+std::string fused_schema_error(const std::string& yaml, const yamln::Schema& schema) {
+    try {
+        yamln::parse(yaml, schema);
+    } catch (const yamln::ParseError& e) {
+        std::string msg = e.what();
+        size_t at = msg.find("Schema violation");
+        return at == std::string::npos ? msg : msg.substr(at);
+    }
+    return std::string();
+}
+
+std::string checked_schema_error(const std::string& yaml, const yamln::Schema& schema) {
+    try {
+        schema.check(yamln::parse(yaml));
+    } catch (const yamln::ParseError& e) {
+        return e.what();
+    } catch (const std::runtime_error& e) {
+        return e.what();
+    }
+    return std::string();
+}
+
+// The fused path must accept exactly what parse-then-check accepts
+void test_schema_fused_matches_check() {
+    yamln::Schema schema(yamln::parse(R"(
+type: object
+properties:
+  name: {type: string}
+  port: {type: integer, minimum: 1}
+  mode: {enum: [fast, safe]}
+  defaults: {type: object}
+  cfg:
+    type: object
+    required: [port]
+    properties:
+      port: {type: integer, minimum: 1}
+  list: {type: array, items: {type: object, properties: {id: {type: integer}}}}
+)"));
+    const char* docs[] = {
+        "name: web\nport: 80\n",
+        "name: 8080\n",
+        "name: null\n",
+        "name: true\n",
+        "name: \"8080\"\n",
+        "mode: fast\n",
+        "mode: slow\n",
+        "defaults: &d {port: -5}\ncfg: *d\n",
+        "defaults: &d {port: 5}\ncfg: *d\n",
+        "defaults: &d {other: 1}\ncfg: *d\n",
+        "defaults: &d\n  port: 0\ncfg: *d\n",
+        "defaults: &d [{id: x}]\nlist: *d\n",
+        "defaults: &d [{id: 3}]\nlist: *d\n",
+        "defaults: &d {id: x}\nlist: [*d]\n",
+        "defaults: &p 0\nport: *p\n",
+        // Only the value a duplicated key keeps is checked
+        "port: x\nport: 8080\n",
+        "port: 8080\nport: x\n",
+        "{port: 0, name: a, port: 1}",
+        "cfg:\n  port: 0\n  port: 2\n",
+        "cfg: {other: 1}\ncfg: {port: 3}\n",
+        "list: [{id: x}]\nmode: slow\nlist: []\nmode: fast\n",
+        "port: x\nname: 1\nport: 2\n",
+    };
+    for (const char* yaml : docs) {
+        std::string fused = fused_schema_error(yaml, schema);
+        std::string checked = checked_schema_error(yaml, schema);
+        check(fused == checked, "parse(yaml, schema) agrees with Schema::check()",
+              std::string(yaml) + " -> " + fused + " | " + checked);
+    }
+
+    // Flat documents with repeated keys; the first violation may differ when
+    // there are several, but both paths must reject the same documents
+    static const char* const keys[] = {"name", "port", "mode"};
+    static const char* const values[] = {"web", "8080", "0", "fast", "slow", "null", "[1]"};
+    Random rng(31);
+    for (int i = 0; i < 2000; ++i) {
+        std::string yaml;
+        for (size_t n = 1 + rng.below(5); n > 0; --n)
+            yaml += std::string(keys[rng.below(3)]) + ": " + values[rng.below(7)] + "\n";
+        std::string checked = checked_schema_error(yaml, schema);
+        std::string fused = fused_schema_error(yaml, schema);
+        if (checked.empty() != fused.empty()) {
+            check(false, "parse(yaml, schema) accepts what Schema::check() accepts", yaml);
+            break;
+        }
+    }
+    check(!fused_schema_error("defaults: &d {port: -5}\ncfg: *d\n", schema).empty(),
+          "rules nested in an aliased container are checked");
+}
+
+void test_schema_rules_through_aliases() {
+    yamln::Schema schema(yamln::parse(R"(
+type: object
+properties:
+  a: &r {type: string}
+  b: *r
+  c: {type: array, items: *r}
+  d:
+    enum:
+      - &v on
+      - *v
+)"));
+    check(fused_schema_error("a: x\nb: y\nc: [z]\nd: on\n", schema).empty(),
+          "aliased rules compile and accept matching values");
+    check(!fused_schema_error("b: 1\n", schema).empty(), "aliased property rule is enforced");
+    check(!fused_schema_error("c: [1]\n", schema).empty(), "aliased items rule is enforced");
+
+    // Unquoted null in a type list is a null node, not the string "null"
+    yamln::Schema nullable(yamln::parse("type: object\nproperties:\n  a: {type: [string, null]}\n"));
+    check(fused_schema_error("a: x\n", nullable).empty() && fused_schema_error("a: null\n", nullable).empty(),
+          "type: [string, null] accepts strings and null");
+    check(!fused_schema_error("a: 1\n", nullable).empty(), "type: [string, null] rejects other types");
+}
+
+// Outcome of parse_into(): the serialized tree, or the error message
+std::string parse_into_result(yamln::ParserContext& ctx, const std::string& yaml, yamln::Node& out) {
+    try {
+        yamln::parse_into(ctx, yaml, out);
+    } catch (const yamln::ParseError& e) {
+        return std::string("error: ") + e.what();
+    }
+    return yamln::serialize(out);
+}
+
+std::string parse_result(const std::string& yaml) {
+    try {
+        return yamln::serialize(yamln::parse(yaml));
+    } catch (const yamln::ParseError& e) {
+        return std::string("error: ") + e.what();
+    }
+}
+
+void test_parse_into_contract() {
+    yamln::ParserContext ctx;
+    yamln::Node out;
+
+    // A failed parse leaves `out` null, whichever stage rejected the input
+    for (const char* bad : {"a: [1, }", "{\"a\": [1,, 2]", "k: \"\xC3\"", "x: *missing"}) {
+        yamln::parse_into(ctx, "a: {b: [1, 2]}\nc: text that is not short\n", out);
+        bool threw = false;
+        try {
+            yamln::parse_into(ctx, bad, out);
+        } catch (const yamln::ParseError&) {
+            threw = true;
+        }
+        check(threw && out.is_null(), "parse_into() leaves `out` null on ParseError", bad);
+    }
+
+    // Anchors end with their document
+    yamln::parse_into(ctx, "a: &x 1\nb: *x\n", out);
+    check(parse_into_result(ctx, "c: *x\n", out) == parse_result("c: *x\n"),
+          "parse_into() does not resolve aliases to anchors of an earlier document");
+
+    // Results the caller kept, and the alias targets in them, survive reuse
+    const char* first = "base: &b {port: 80, name: a long enough string}\nweb: *b\nlist: [1, 2, 3]\n";
+    yamln::parse_into(ctx, first, out);
+    yamln::Node kept = out;
+    for (const char* next : {"base: &b {port: 81}\nweb: *b\n", "list: [4]\n", "{\"base\": 1}"})
+        yamln::parse_into(ctx, next, out);
+    check(yamln::serialize(kept) == parse_result(first), "copies of an earlier result stay intact");
+    check(kept["web"].is_alias() && kept["web"].as_alias()["port"].as_number() == 80,
+          "alias targets of an earlier result are not overwritten");
+
+    ctx.clear();
+    check(parse_into_result(ctx, first, out) == parse_result(first), "parse_into() works after clear()");
+
+    // Reusing one context and one Node across a stream of documents gives
+    // what parse() gives for each of them
+    yamln::Node reused;
+    for (const std::string& doc : make_fuzz_corpus()) {
+        std::string got = parse_into_result(ctx, doc, reused);
+        std::string expected = parse_result(doc);
+        if (got != expected) {
+            check(false, "parse_into() agrees with parse()", doc + " -> " + got + " | " + expected);
+            break;
+        }
+    }
+}
+
+// Tree from the generic flow grammar, bypassing the JSON fast path, or the
+// error message
+std::string flow_parse_result(const std::string& text) {
+    try {
+        yamln::Parser p(text);
+        return yamln::serialize_json(p.parse_document());
+    } catch (const yamln::ParseError& e) {
+        return std::string("error: ") + e.what();
+    }
+}
+
+void test_json_fast_path() {
+    // Strict JSON: the fast path must accept it and build the flow grammar's tree
+    const char* strict[] = {
+        "{\"a\": {\"b\": [1, 2, {\"c\": null}]}, \"d\": [true, false], \"e\": \"\", \"f\": {}, \"g\": []}",
+        "[[[]], [{}], [[1], [2, [3]]]]",
+        "[\"q\\\"b\\\\s\\/ \\b\\f\\n\\r\\t\", \"\\u00e9\\u4e2d\\ud83d\\ude00\", \"\\u0001\"]",
+        "[0, -0, 7, -12, 2147483647, -2147483648, 2147483648, -2147483649, 12345678901]",
+        "[1.5, -2.25e3, 1E-2, 0.1, 6.02e+23, 1e-7, 0.0, -0.0]",
+        " \n\t{\"k\": \"v\"} \n",
+        "{\"dup\": 1, \"dup\": 2}",
+    };
+    for (const std::string text : strict) {
+        yamln::JsonParser jp(text);
+        yamln::Node fast;
+        bool accepted = jp.parse_document(fast);
+        check(accepted, "JSON fast path accepts strict JSON", text);
+        std::string expected = flow_parse_result(text);
+        check(accepted && yamln::serialize_json(fast) == expected, "JSON fast path builds the flow grammar's tree",
+              text + " -> " + yamln::serialize_json(fast) + " | " + expected);
+        check(yamln::parse(text) == fast, "parse() uses the JSON fast path result", text);
+    }
+
+    // Starts like JSON but is not: the fast path declines and parse() gives
+    // the YAML grammar's answer
+    const char* loose[] = {
+        "[1, 2,]", "{\"a\": 1,}", "{\"a\": 1} # comment", "[1, # note\n 2]", "{a: 1}",
+        "[yes, ~, 'x', plain words]", "[1, 2] trailing", "[\"a\", .5]", "[01]", "[+1]", "[\"\t\"]",
+        "{\"a\" : [1 2]}", "[\"\\x41\"]", "[\"\\ud800\"]", "[",
+    };
+    for (const std::string text : loose) {
+        yamln::JsonParser jp(text);
+        yamln::Node fast;
+        check(!jp.parse_document(fast), "JSON fast path declines input that is not strict JSON", text);
+        std::string got;
+        try {
+            got = yamln::serialize_json(yamln::parse(text));
+        } catch (const yamln::ParseError& e) {
+            got = std::string("error: ") + e.what();
+        }
+        std::string expected = flow_parse_result(text);
+        check(got == expected, "parse() falls back to the YAML grammar", text + " -> " + got + " | " + expected);
+    }
+}
+
+void test_serialize_json_round_trip() {
+    yamln::Node n;
+    n["special"] = yamln::Sequence{yamln::Node(std::nan("")), yamln::Node(HUGE_VAL), yamln::Node(-HUGE_VAL)};
+    check(yamln::serialize_json(n) == "{\"special\":[null,null,null]}", "serialize_json() writes NaN and infinities as null",
+          yamln::serialize_json(n));
+
+    yamln::Node values;
+    std::string controls;
+    for (int c = 1; c < 0x20; ++c) controls += (char)c;
+    values["controls"] = controls + "\x7f\"\\/ \xC3\xA9";
+    values["doubles"] = yamln::Sequence{
+        yamln::Node(1e300), yamln::Node(-1.7976931348623157e308), yamln::Node(0.1), yamln::Node(4.9e-324),
+        yamln::Node(9007199254740993.0), yamln::Node(1e16), yamln::Node(5.0), yamln::Node(-0.0),
+        yamln::Node(2.5e-8), yamln::Node(123456789.123456789)};
+    values["ints"] = yamln::Sequence{yamln::Node(2147483647), yamln::Node(-2147483647 - 1), yamln::Node(0)};
+    values["nested"]["key with \"quotes\"\n"] = yamln::Sequence{yamln::Node(true), yamln::Node()};
+    std::string json = yamln::serialize_json(values);
+    yamln::Node back;
+    yamln::JsonParser jp(json);
+    check(jp.parse_document(back), "serialize_json() output is strict JSON", json);
+    check(back == values, "serialize_json() round-trips through parse()", json);
+
+    Random rng(28);
+    for (int i = 0; i < 2000; ++i) {
+        std::uint64_t bits = rng.next();
+        double d;
+        std::memcpy(&d, &bits, sizeof d);
+        if (!std::isfinite(d)) continue;
+        yamln::Node parsed = yamln::parse(yamln::serialize_json(yamln::Node(yamln::Sequence{yamln::Node(d)})));
+        if (!(parsed[0] == yamln::Node(d))) {
+            check(false, "serialize_json() writes doubles that read back exactly", yamln::serialize_json(yamln::Node(d)));
+            break;
+        }
+    }
+}
+
+// The error parse() throws for `yaml`, which validate() must report too
+std::optional<yamln::ParseError> parse_failure(const std::string& yaml) {
+    std::optional<yamln::ParseError> error;
+    try {
+        yamln::parse(yaml);
+    } catch (const yamln::ParseError& e) {
+        error = e;
+    }
+    std::optional<yamln::ParseError> validated = yamln::validate(yaml);
+    check(validated.has_value() == error.has_value() &&
+          (!error || std::string(validated->what()) == error->what()),
+          "validate() reports what parse() throws", yaml);
+    return error;
+}
+
+void test_double_quoted_escapes() {
+    static const struct { const char* escape; const char* bytes; } cases[] = {
+        {"\\x41", "A"}, {"\\xe9", "\xC3\xA9"}, {"\\xFF", "\xC3\xBF"},
+        {"\\u00e9", "\xC3\xA9"}, {"\\u4E2D", "\xE4\xB8\xAD"}, {"\\ud83d\\ude00", "\xF0\x9F\x98\x80"},
+        {"\\U0001F600", "\xF0\x9F\x98\x80"}, {"\\U0010FFFF", "\xF4\x8F\xBF\xBF"},
+        {"\\N", "\xC2\x85"}, {"\\_", "\xC2\xA0"}, {"\\L", "\xE2\x80\xA8"}, {"\\P", "\xE2\x80\xA9"},
+        {"\\a\\b\\t\\n\\v\\f\\r\\e", "\a\b\t\n\v\f\r\x1B"}, {"\\ \\\"\\/\\\\", " \"/\\"},
+        {"a\\\n    b", "ab"}, {"a\\\r\n  b", "ab"},
+    };
+    for (const auto& c : cases) {
+        std::string yaml = std::string("k: \"") + c.escape + "\"\n";
+        bool ok = !parse_failure(yaml) && yamln::parse(yaml)["k"].as_string() == c.bytes;
+        check(ok, "double-quoted escape decodes to UTF-8", c.escape);
+    }
+    std::string nul = yamln::parse("k: \"a\\0b\"")["k"].as_string();
+    check(nul == std::string("a\0b", 3), "\\0 decodes to a NUL byte");
+
+    // Rejected at the backslash (column 7), or at the first bad hex digit
+    static const struct { const char* escape; int col; } bad[] = {
+        {"\\ud800", 7}, {"\\udc00", 7}, {"\\ud800\\u0041", 7}, {"\\ud800x", 7}, {"\\U00110000", 7},
+        {"\\U0000DFFF", 7}, {"\\q", 7}, {"\\x4", 10}, {"\\xZZ", 9}, {"\\u12G4", 11},
+    };
+    for (const auto& c : bad) {
+        std::optional<yamln::ParseError> e = parse_failure(std::string("k: \"ab") + c.escape + "\"\n");
+        check(e && e->line == 1 && e->col == c.col, "invalid escape is rejected at its position",
+              std::string(c.escape) + " -> " + (e ? e->what() : "accepted"));
+    }
+    check(parse_failure("k: \"ab\\").has_value(), "escape cut off by the end of input is rejected");
+}
+
+void test_utf8_is_required() {
+    // Overlong, surrogate, past U+10FFFF, stray continuation, invalid byte,
+    // then sequences cut short by the next character
+    for (const char* bad : {"\xC0\xAF", "\xE0\x80\xAF", "\xF0\x80\x80\xAF", "\xED\xA0\x80", "\xF4\x90\x80\x80",
+                            "\x80", "\xFF", "\xC3", "\xE2\x82", "\xF0\x9F\x98"}) {
+        std::optional<yamln::ParseError> e = parse_failure(std::string("a: ok\nb: x") + bad + "y\n");
+        check(e && e->line == 2 && e->col == 5 && std::string(e->what()).find("Invalid UTF-8") != std::string::npos,
+              "malformed UTF-8 is rejected at its first byte", e ? e->what() : "accepted");
+        e = parse_failure(std::string("[\"") + bad + "\"]");
+        check(e && e->line == 1 && e->col == 3, "malformed UTF-8 in JSON is rejected", e ? e->what() : "accepted");
+    }
+    // Truncated at the very end of the input
+    std::optional<yamln::ParseError> e = parse_failure("k: \xE2\x82");
+    check(e && e->line == 1 && e->col == 4, "UTF-8 truncated at the end of input is rejected");
+    check(!parse_failure("k: \"\xF0\x9F\x98\x80 \xE4\xB8\xAD \xC3\xA9 \xF4\x8F\xBF\xBF\"\n"), "well-formed UTF-8 is accepted");
+}
+
+void test_block_scalars() {
+    static const struct { const char* yaml; const char* value; } cases[] = {
+        // Chomping: clip keeps one final break, strip none, keep all
+        {"k: |\n  a\n  b\n\n\nn: 1\n", "a\nb\n"},
+        {"k: |-\n  a\n  b\n\n\nn: 1\n", "a\nb"},
+        {"k: |+\n  a\n  b\n\n\nn: 1\n", "a\nb\n\n\n"},
+        {"k: >\n  a\n  b\n\n  c\n", "a b\nc\n"},
+        {"k: >-\n  a\n  b\n\n", "a b"},
+        {"k: >+\n  a\n  b\n\n", "a b\n\n"},
+        {"k: |\n  a\n  b", "a\nb\n"},
+        {"k: |\n", ""},
+        {"k: |+\n\n\n", "\n\n"},
+        // Leading and inner blank lines
+        {"k: |\n\n\n  a\n", "\n\na\n"},
+        {"k: >\n\n  a\n  b\n", "\na b\n"},
+        {"k: >\n  a\n\n\n  b\n", "a\n\nb\n"},
+        {"k: |\n  a\n   \n  b\n", "a\n\nb\n"},
+        // Lines indented past the block keep the extra spaces, and folding
+        // keeps the breaks around them
+        {"k: |\n  a\n    b\n  c\n", "a\n  b\nc\n"},
+        {"k: >\n  a\n    b\n  c\n", "a\n  b\nc\n"},
+        {"k: >\n  a\n\n    b\n\n  c\n", "a\n\n  b\n\nc\n"},
+        {"k: >\n  a\n  b\n    c\n    d\n  e\n", "a b\n  c\n  d\ne\n"},
+        // CRLF and lone CR line endings
+        {"k: |\r\n  a\r\n  b\r\n\r\nn: 1\r\n", "a\nb\n"},
+        {"k: >\r\n  a\r\n  b\r\n\r\n  c\r\n", "a b\nc\n"},
+        {"k: |+\r\n  a\r\n\r\n", "a\n\n"},
+        {"k: |\n  a\r  b\n", "a\nb\n"},
+        {"k: |\r  a\r\r  b\r", "a\n\nb\n"},
+        {"k: | # note\r\n  a\r\n", "a\n"},
+        {"- |\n  x\n  y\n- 2\n", "x\ny\n"},
+    };
+    for (const auto& c : cases) {
+        std::string got;
+        try {
+            yamln::Node n = yamln::parse(c.yaml);
+            got = (n.is_mapping() ? n["k"] : n[0]).as_string();
+        } catch (const std::exception& e) {
+            got = std::string("error: ") + e.what();
+        }
+        check(got == c.value, "block scalar value", c.yaml);
+        check(!yamln::validate(c.yaml), "validate() accepts the block scalar", c.yaml);
+    }
+    check(yamln::parse("k: |\n  a\nn: 1\n")["n"].as_number() == 1, "a block scalar ends at the next key");
+
+    // The first pass sizes the value exactly: the copy fills one buffer of
+    // that size instead of growing into a bigger one
+    for (const char* header : {"|", ">", "|+", ">-"}) {
+        std::string yaml = std::string("k: ") + header + "\n";
+        for (int i = 0; i < 2000; ++i) {
+            yaml += (i % 7 == 3 ? "    " : "  ") + std::string(48, (char)('a' + i % 26)) + (i % 3 ? "\n" : "\r\n");
+            if (i % 11 == 0) yaml += "\n";
+        }
+        size_t before = g_allocated.load();
+        yamln::Node n = yamln::parse(yaml);
+        size_t bytes = g_allocated.load() - before;
+        size_t len = n["k"].as_string().size();
+        check(bytes < len + len / 4, "block scalar is copied into one exactly sized buffer",
+              std::string(header) + ": " + std::to_string(bytes) + " bytes for " + std::to_string(len));
+    }
+
+    // Random bodies mixing indentation, blank lines and line endings; the
+    // parser asserts that both passes agree
+    static const char* const eols[] = {"\n", "\r\n", "\r"};
+    static const char* const headers[] = {"|", "|-", "|+", ">", ">-", ">+"};
+    Random rng(29);
+    for (int i = 0; i < 5000; ++i) {
+        std::string yaml = std::string("k: ") + headers[rng.below(6)] + eols[rng.below(3)];
+        for (size_t n = rng.below(8); n > 0; --n) {
+            size_t kind = rng.below(5);
+            if (kind == 0) yaml += std::string(rng.below(4), ' ');
+            else yaml += std::string(kind == 1 ? 4 : 2, ' ') + "w" + std::to_string(rng.below(100));
+            yaml += eols[rng.below(3)];
+        }
+        if (rng.below(2)) yaml += "n: 1\n";
+        std::optional<yamln::ParseError> e = parse_failure(yaml);
+        check(!e, "random block scalar parses", yaml + (e ? std::string(" -> ") + e->what() : ""));
+    }
+}
+
+// with() against std::map / std::vector models, through inserts that split
+// chunks and writes past the end that re-chunk sequences
+void test_frozen_with_matches_model() {
+    Random rng(42);
+    yamln::FrozenNode root{yamln::Node(yamln::Mapping{})};
+    std::map<std::string, int> map_model;
+    std::vector<int> seq_model;
+    std::vector<yamln::FrozenNode> versions;
+    for (int i = 0; i < 3000; ++i) {
+        int v = (int)rng.below(1000);
+        if (rng.below(2)) {
+            std::string key = "k" + std::to_string(rng.below(1500));
+            root = root.with(yamln::Path{std::string("m"), key}, yamln::Node(v));
+            map_model[key] = v;
+        } else {
+            size_t index = rng.below(seq_model.size() + (rng.below(50) ? 2 : 400));
+            root = root.with(yamln::Path{std::string("s"), index}, yamln::Node(v));
+            if (index >= seq_model.size()) seq_model.resize(index + 1, -1);
+            seq_model[index] = v;
+        }
+        if (i % 500 == 0) versions.push_back(root);
+    }
+
+    const yamln::FrozenMapping& map = root["m"].as_mapping();
+    check(map.size() == map_model.size(), "FrozenMapping size follows inserts");
+    auto it = map.begin();
+    for (const auto& kv : map_model) {
+        bool ok = it != map.end() && it->first == kv.first && it->second.as_number() == kv.second;
+        check(ok, "FrozenMapping iterates in key order with the latest values", kv.first);
+        if (!ok) break;
+        check(map.at(kv.first).as_number() == kv.second, "FrozenMapping::at finds every key", kv.first);
+        ++it;
+    }
+    check(map.find("missing") == nullptr, "FrozenMapping::find misses absent keys");
+
+    const yamln::FrozenSequence& seq = root["s"].as_sequence();
+    check(seq.size() == seq_model.size(), "FrozenSequence size follows writes past the end");
+    for (size_t i = 0; i < seq.size() && i < seq_model.size(); ++i) {
+        bool ok = seq_model[i] < 0 ? seq[i].is_null() : seq[i].as_number() == seq_model[i];
+        check(ok, "FrozenSequence holds the latest value at every index", std::to_string(i));
+        if (!ok) break;
+    }
+    check(root == yamln::FrozenNode(root.thaw()), "thaw() and refreeze round-trips");
+    check(versions.size() > 1 && !(versions.front() == root), "older versions are unaffected by with()");
+}
+
+// Readers load() while writers store() whole versions and update() single
+// keys. Every version a reader sees must be complete, and one it still holds
+// must stay intact after later versions retire it.
+yamln::FrozenNode make_snapshot_version(int v) {
+    yamln::Node n;
+    n["v"] = v;
+    n["copy"] = v;
+    for (int i = 0; i < 32; ++i) n["items"][(size_t)i] = v;
+    return yamln::FrozenNode(n);
+}
+
+void test_snapshot_holder_concurrent() {
+    static_assert(!std::is_constructible<yamln::FrozenNode, std::shared_ptr<const yamln::FrozenValue>>::value,
+                  "only make_frozen() wraps a raw FrozenValue");
+
+    const int versions = 2000;
+    yamln::SnapshotHolder holder(make_snapshot_version(0));
+    yamln::FrozenNode held = holder.load();
+    std::atomic<bool> done{false};
+    std::atomic<int> torn{0}, backwards{0};
+
+    auto reader = [&] {
+        int last = 0;
+        while (!done.load(std::memory_order_acquire)) {
+            yamln::FrozenNode s = holder.load();
+            int v = (int)s["v"].as_number();
+            bool whole = s["copy"].as_number() == v && s["items"].as_sequence().size() == 32;
+            for (const yamln::FrozenNode& item : s["items"].as_sequence()) whole = whole && item.as_number() == v;
+            if (!whole) torn.fetch_add(1);
+            if (v < last) backwards.fetch_add(1);
+            last = v;
+        }
+    };
+
+    // Readers that only load() spend most of their time inside it, where a
+    // version released too early would be read after it is freed
+    auto loader = [&] {
+        while (!done.load(std::memory_order_acquire)) {
+            yamln::FrozenNode s = holder.load();
+            if (s.hash() == 0) torn.fetch_add(1);
+        }
+    };
+
+    std::vector<std::thread> readers;
+    for (int i = 0; i < 2; ++i) {
+        readers.emplace_back(reader);
+        readers.emplace_back(loader);
+    }
+    for (int v = 1; v <= versions; ++v) holder.store(make_snapshot_version(v));
+    done.store(true, std::memory_order_release);
+    for (std::thread& t : readers) t.join();
+    check(torn.load() == 0, "load() never sees a partially built version", std::to_string(torn.load()));
+    check(backwards.load() == 0, "a reader never sees an older version after a newer one");
+    check(held["v"].as_number() == 0 && held["items"][31].as_number() == 0,
+          "a held snapshot outlives the versions that replaced it");
+
+    // Two writers update their own key; updates must not be lost to each other
+    done.store(false);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; ++i) {
+        threads.emplace_back([&] {
+            int last[2] = {0, 0};
+            while (!done.load(std::memory_order_acquire)) {
+                yamln::FrozenNode s = holder.load();
+                for (int w = 0; w < 2; ++w) {
+                    const yamln::FrozenNode* n = s.as_mapping().find("w" + std::to_string(w));
+                    int count = n ? (int)n->as_number() : 0;
+                    if (count < last[w]) backwards.fetch_add(1);
+                    last[w] = count;
+                }
+                if (s["v"].as_number() != versions) torn.fetch_add(1);
+            }
+        });
+    }
+    std::vector<std::thread> writers;
+    for (int w = 0; w < 2; ++w) {
+        writers.emplace_back([&holder, w] {
+            for (int i = 1; i <= 1000; ++i) holder.update("w" + std::to_string(w), yamln::Node(i));
+        });
+    }
+    for (std::thread& t : writers) t.join();
+    done.store(true, std::memory_order_release);
+    for (std::thread& t : threads) t.join();
+    yamln::FrozenNode last = holder.load();
+    check(last["w0"].as_number() == 1000 && last["w1"].as_number() == 1000, "concurrent update() calls are all kept");
+    check(torn.load() == 0 && backwards.load() == 0, "update() publishes whole versions in order");
+}
+
+// One edit under a wide root must not copy the root's keys
+void test_frozen_with_shares_storage() {
+    yamln::Node wide;
+    for (int i = 0; i < 10000; ++i) wide["key_with_a_longish_name_" + std::to_string(i)] = i;
+    yamln::FrozenNode root(wide);
+
+    size_t before = g_allocated.load();
+    yamln::FrozenNode next = root.with("key_with_a_longish_name_5000", yamln::Node("x"));
+    size_t bytes = g_allocated.load() - before;
+
+    check(next["key_with_a_longish_name_5000"].as_string() == "x", "with() stores the new value");
+    check(root["key_with_a_longish_name_5000"].as_number() == 5000, "with() leaves the original intact");
+    // A full copy of the root is about 10000 keys plus 10000 handles (> 1 MB)
+    check(bytes < 32 * 1024, "with() copies O(sqrt(width)) of a 10k-key mapping",
+          std::to_string(bytes) + " bytes");
+}
+
+// Pins the text format, which the two-pass emitter must keep. Empty
+// containers under a key have always started a line of their own.
+void test_serialize_format() {
+    yamln::Node n;
+    n["list"] = yamln::Sequence{yamln::Node(1), yamln::Node(2.5), yamln::Node(-0.0), yamln::Node(true), yamln::Node()};
+    n["keys"][""] = 1;
+    n["keys"]["a b"] = 2;
+    n["keys"]["_x-1"] = 3;
+    n["keys"]["9a"] = "q\"\\z";
+    n["empty"] = yamln::Sequence{};
+    n["nested"]["inner"] = yamln::Mapping{};
+    const char* expected =
+        "empty:\n"
+        "[]\n"
+        "keys:\n"
+        "  \"\": 1\n"
+        "  \"9a\": \"q\\\"\\\\z\"\n"
+        "  _x-1: 3\n"
+        "  \"a b\": 2\n"
+        "list:\n"
+        "  - 1\n"
+        "  - 2.5\n"
+        "  - -0\n"
+        "  - true\n"
+        "  - null\n"
+        "nested:\n"
+        "  inner:\n"
+        "{}";
+    check(yamln::serialize(n) == expected, "serialize() keeps its output format", yamln::serialize(n));
+
+    yamln::Node anchored = yamln::parse("a: &x {b: 1}\nc: *x\n");
+    check(yamln::serialize(anchored) == "a: &x\n  b: 1\nc: *x", "serialize() writes anchors and aliases",
+          yamln::serialize(anchored));
+    check(yamln::serialize(yamln::Node(2.5)) == "2.5", "serialize() writes a scalar root");
+}
+
+// serialize_parallel() must produce exactly the text of serialize()
+void test_serialize_parallel_matches() {
+    std::vector<yamln::Node> trees;
+    for (const std::string& doc : make_fuzz_corpus()) {
+        try {
+            trees.push_back(yamln::parse(doc));
+        } catch (const yamln::ParseError&) {
+        }
+    }
+    yamln::Node wide;
+    for (int i = 0; i < 5000; ++i) wide["entry" + std::to_string(i)]["v"] = yamln::Sequence{yamln::Node(i), yamln::Node("s")};
+    trees.push_back(wide);
+
+    for (const yamln::Node& tree : trees) {
+        std::string expected = yamln::serialize(tree);
+        for (unsigned threads : {1u, 2u, 3u, 8u}) {
+            bool ok = yamln::serialize_parallel(tree, threads) == expected;
+            check(ok, "serialize_parallel() matches serialize()", expected.substr(0, 80));
+            if (!ok) return;
+        }
+    }
+}
+
+// Bytes that matter to some kernel, padded with plain text so matches are
+// spread out; a trailing run lets tails of every length occur
+std::vector<char> make_scan_buffer(Random& rng) {
+    static const char special[] = {'"', '\\', ':', '#', '\n', '\r', ',', ']', '}', '\0', '\x1f', '\x7f', ' '};
+    std::vector<char> buf(rng.below(300));
+    size_t density = 1 + rng.below(64);
+    for (char& c : buf) {
+        size_t r = rng.below(density);
+        if (r == 0) c = special[rng.below(sizeof special)];
+        else if (r == 1) c = (char)(0x80 + rng.below(0x80));
+        else c = (char)('a' + rng.below(26));
+    }
+    return buf;
+}
+
+// Mostly valid UTF-8 with one corruption in some buffers: a flipped or
+// dropped byte, an overlong form, a surrogate or a code point past U+10FFFF
+std::vector<char> make_utf8_buffer(Random& rng) {
+    std::string out;
+    size_t chars = rng.below(120);
+    for (size_t i = 0; i < chars; ++i) {
+        std::uint32_t cp;
+        switch (rng.below(4)) {
+            case 0: cp = (std::uint32_t)rng.below(0x80); break;
+            case 1: cp = 0x80 + (std::uint32_t)rng.below(0x780); break;
+            case 2: cp = 0x800 + (std::uint32_t)rng.below(0xF800); break;
+            default: cp = 0x10000 + (std::uint32_t)rng.below(0x100000); break;
+        }
+        if (cp >= 0xD800 && cp <= 0xDFFF) cp = 'x';
+        if (cp < 0x80) {
+            out += (char)cp;
+        } else if (cp < 0x800) {
+            out += (char)(0xC0 | cp >> 6);
+            out += (char)(0x80 | (cp & 0x3F));
+        } else if (cp < 0x10000) {
+            out += (char)(0xE0 | cp >> 12);
+            out += (char)(0x80 | (cp >> 6 & 0x3F));
+            out += (char)(0x80 | (cp & 0x3F));
+        } else {
+            out += (char)(0xF0 | cp >> 18);
+            out += (char)(0x80 | (cp >> 12 & 0x3F));
+            out += (char)(0x80 | (cp >> 6 & 0x3F));
+            out += (char)(0x80 | (cp & 0x3F));
+        }
+    }
+    if (!out.empty() && rng.below(2)) {
+        static const char* const bad[] = {"\xC0\xAF", "\xE0\x80\xAF", "\xED\xA0\x80", "\xF4\x90\x80\x80",
+                                          "\x80", "\xC3", "\xE2\x82", "\xF0\x9F\x98", "\xFF"};
+        size_t at = rng.below(out.size());
+        switch (rng.below(3)) {
+            case 0: out[at] = (char)(out[at] ^ (1 << rng.below(8))); break;
+            case 1: out.erase(at, 1); break;
+            default: out.insert(at, bad[rng.below(sizeof bad / sizeof bad[0])]); break;
+        }
+    }
+    return std::vector<char>(out.begin(), out.end());
+}
+
+// Compares one table against the scalar kernels, stopping at the first mismatch
+void check_scan_table(const yamln::ScanKernels& k, const yamln::ScanKernels& ref, Random& rng) {
+    for (int n = 0; n < 20000; ++n) {
+        std::vector<char> buf = make_scan_buffer(rng);
+        const char* end = buf.data() + buf.size();
+        for (size_t off = 0; off < 4 && off <= buf.size(); ++off) {
+            const char* p = buf.data() + off;
+            if (k.find_quote_or_backslash(p, end) != ref.find_quote_or_backslash(p, end) ||
+                k.find_json_escape(p, end) != ref.find_json_escape(p, end) ||
+                k.find_plain_stop(p, end) != ref.find_plain_stop(p, end)) {
+                check(false, "scan kernels agree with scalar", std::string(k.name) + ", " +
+                      std::to_string(buf.size()) + " bytes at offset " + std::to_string(off));
+                return;
+            }
+        }
+
+        std::vector<char> text = make_utf8_buffer(rng);
+        bool expected = ref.validate_utf8(text.data(), text.size());
+        if (k.validate_utf8(text.data(), text.size()) != expected ||
+            expected != (yamln::invalid_utf8_offset(text.data(), text.size()) == text.size())) {
+            check(false, "validate_utf8 agrees with scalar", std::string(k.name) + ", " +
+                  std::to_string(text.size()) + " bytes");
+            return;
+        }
+    }
+}
+
+// Every vector table must answer exactly like the scalar one. Buffers are
+// allocated at their exact size, so over-reads show up under AddressSanitizer.
+void test_scan_kernels_match_scalar() {
+    const yamln::ScanKernels& ref = *yamln::scan_kernels(yamln::Isa::Scalar);
+    for (yamln::Isa isa : {yamln::Isa::SSE42, yamln::Isa::AVX2, yamln::Isa::AVX512}) {
+        Random rng(7 + (std::uint64_t)isa);
+        if (const yamln::ScanKernels* k = yamln::scan_kernels(isa)) check_scan_table(*k, ref, rng);
+    }
+}
+
+// AVX-512 is only used when asked for
+void test_scan_default_level() {
+    if (std::getenv("YAMLN_ISA")) return;
+    check(std::strcmp(yamln::active_scan_kernels().name, "avx512") != 0,
+          "AVX-512 kernels are not selected by default");
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const char* group = argc > 1 ? argv[1] : "";
+    bool all = !*group;
+
+    if (all || !std::strcmp(group, "api")) {
+        test_stray_brace_in_flow_sequence();
+        test_validate_matches_parse();
+        test_direct_edits_are_compared();
+        test_nested_aliases_hash_once();
+        test_frozen_diff_matches_node_diff();
+        test_schema_fused_matches_check();
+        test_schema_rules_through_aliases();
+        test_parse_into_contract();
+        test_json_fast_path();
+        test_serialize_json_round_trip();
+        test_double_quoted_escapes();
+        test_utf8_is_required();
+        test_block_scalars();
+        test_frozen_with_matches_model();
+        test_frozen_with_shares_storage();
+        test_snapshot_holder_concurrent();
+        test_serialize_format();
+        test_serialize_parallel_matches();
+    }
+    if (all || !std::strcmp(group, "scan")) {
+        test_scan_kernels_match_scalar();
+        test_scan_default_level();
+    }
+
+    if (g_failures) std::fprintf(stderr, "%d check(s) failed\n", g_failures);
+    else std::printf("all checks passed\n");
+    return g_failures > 100 ? 100 : g_failures;
+}